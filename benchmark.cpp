@@ -0,0 +1,1613 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+// SSE2 is part of x86-64, AVX2 is checked at run time
+#if defined(__x86_64__) && defined(__GNUC__)
+#define BENCHMARK_X86 1
+#include <immintrin.h>
+#endif
+
+#include "include/batch.h"
+#include "include/delaunay.h"
+#include "include/dendrogram.h"
+#include "include/predicates.h"
+#include "include/query.h"
+#include "include/snapshot.h"
+#include "include/streaming.h"
+
+// Headless benchmark: times preprocess (sort and duplicates removal),
+// triangulation and MST phases on generated distributions, prints a table
+// and optionally writes a json report meant to be diffed between versions.
+
+namespace {
+
+const char *const kDistributions[] = {"uniform", "clusters", "grid",
+                                      "lines", "duplicates"};
+
+struct Options {
+  std::vector<size_t> sizes = {1000, 10000, 100000, 1000000};
+  std::vector<std::string> distributions =
+      std::vector<std::string>(std::begin(kDistributions),
+                               std::end(kDistributions));
+  int reps = 5;
+  int threads = 1;
+  bool kruskal = true;
+  bool boruvka = true;
+  bool hilbert = false; // reorders vertices and edges before mst and queries
+  std::vector<SplitStrategy> splits = {SplitStrategy::Vertical};
+  std::vector<std::string> scalars = {"float"}; // coordinate types
+  size_t queries = 100000;
+  size_t batch = 0;  // independent systems of 1e3 to 1e5 points, 0: none
+  size_t predicates = 0; // tests per predicate throughput measure, 0: none
+  bool reuse = false; // one DivideConquer for all repetitions of a case
+  std::string json;  // report file, none if empty, stdout if "-"
+  std::string trace; // chrome trace of the last case, none if empty
+  std::string snapshot; // snapshot file saved and mapped per case, or none
+  size_t stream_budget = 0; // bytes of out-of-core triangulation, 0: none
+  bool check = false; // brute force checks instead of measures
+};
+
+// samples of one phase, in seconds
+struct Samples {
+  std::vector<double> values;
+
+  double percentile(double p) const {
+    std::vector<double> v(values);
+    std::sort(v.begin(), v.end());
+    if (v.empty()) {
+      return 0.0;
+    }
+    double rank = p * (v.size() - 1);
+    size_t lo = static_cast<size_t>(rank);
+    size_t hi = std::min(lo + 1, v.size() - 1);
+    return v[lo] + (rank - lo) * (v[hi] - v[lo]);
+  }
+};
+
+struct Case {
+  std::string distribution;
+  std::string scalar = "float";
+  SplitStrategy split = SplitStrategy::Vertical;
+  size_t size = 0;
+  size_t num_vertices = 0;
+  size_t num_edges = 0;
+  size_t num_deleted_edges = 0; // created by merges then disconnected
+  size_t edge_bytes = 0;
+  size_t peak_rss = 0;
+  size_t allocations = 0; // by triangulation and spanning trees, last rep
+  float min_d = 0;
+  Samples preprocess;
+  Samples sort;
+  Samples dedup;
+  Samples triangulation;
+  Samples kruskal;
+  Samples boruvka;
+  Samples dendrogram; // built from the spanning tree of last backend
+  Samples reorder;
+  Samples query; // nearest vertex of all query points
+  Samples snapshot_save; // float coordinates only
+  Samples snapshot_open; // checksum verified
+  size_t snapshot_bytes = 0;
+  Samples stream_triangulation; // StreamingDelaunay, float coordinates only
+  Samples stream_mst;           // StreamingMst of its file
+  size_t stream_peak_vertices = 0;
+  TriangulationStats stats; // of last repetition
+};
+
+// many systems through BatchTriangulator
+struct BatchCase {
+  size_t systems = 0;
+  size_t points = 0;
+  Samples run; // whole batch, first repetition pays for allocations
+};
+
+// throughput of the predicates, one test per call or a kernel of batches
+struct PredicateCase {
+  std::string kernel; // "single" for incircle and orient2d
+  Samples incircle;   // seconds for all tests
+  Samples orient;
+};
+
+void usage() {
+  std::cout
+      << "usage: benchmark [options]\n"
+         "  --sizes a,b,..   numbers of points (default 1e3,1e4,1e5,1e6)\n"
+         "  --dists a,b,..   uniform,clusters,grid,lines,duplicates (all)\n"
+         "  --reps n         repetitions per case (5)\n"
+         "  --threads n      triangulation threads (1)\n"
+         "  --mst m          kruskal, boruvka or both (both)\n"
+         "  --split s        vertical, alternating or both (vertical)\n"
+         "  --scalar s       float, double, int32 or all coordinates (float)\n"
+         "  --hilbert        reorders vertices along a Hilbert curve\n"
+         "  --reuse          reuses one object for all repetitions\n"
+         "  --queries n      nearest vertex queries per case (1e5), 0: none\n"
+         "  --batch n        also runs n systems of 1e3..1e5 points as a\n"
+         "                   batch on --threads (0)\n"
+         "  --predicates n   also times n in-circle and orientation tests\n"
+         "                   per call and per batch kernel (0)\n"
+         "  --json file      writes report to file, - for stdout\n"
+         "  --trace file     writes chrome trace of last case (needs\n"
+         "                   DELAUNAY_STATS for merge events)\n"
+         "  --snapshot file  saves each float case to a snapshot file and\n"
+         "                   maps it back\n"
+         "  --stream bytes   also triangulates each float case out of core\n"
+         "                   with this memory budget, then its tree\n"
+         "  --check          checks small triangulations by brute force\n"
+         "                   instead, fails if any is wrong\n";
+}
+
+std::vector<std::string> split(const std::string &s) {
+  std::vector<std::string> out;
+  std::stringstream stream(s);
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    if (!item.empty()) {
+      out.push_back(item);
+    }
+  }
+  return out;
+}
+
+bool parseOptions(int argc, char *argv[], Options &options) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--help" || arg == "-h") {
+      return false;
+    }
+    if (arg == "--hilbert") {
+      options.hilbert = true;
+      continue;
+    }
+    if (arg == "--reuse") {
+      options.reuse = true;
+      continue;
+    }
+    if (arg == "--check") {
+      options.check = true;
+      continue;
+    }
+    if (i + 1 >= argc) {
+      std::cerr << "missing value for " << arg << std::endl;
+      return false;
+    }
+    std::string value = argv[++i];
+    if (arg == "--sizes") {
+      options.sizes.clear();
+      for (const std::string &s : split(value)) {
+        // accepts 1e6 as well as 1000000
+        options.sizes.push_back(static_cast<size_t>(std::strtod(s.c_str(),
+                                                                nullptr)));
+      }
+    } else if (arg == "--dists") {
+      options.distributions = split(value);
+      for (const std::string &d : options.distributions) {
+        if (std::find_if(std::begin(kDistributions), std::end(kDistributions),
+                         [&d](const char *k) { return d == k; }) ==
+            std::end(kDistributions)) {
+          std::cerr << "unknown distribution " << d << std::endl;
+          return false;
+        }
+      }
+    } else if (arg == "--reps") {
+      options.reps = std::max(1, std::atoi(value.c_str()));
+    } else if (arg == "--threads") {
+      options.threads = std::max(1, std::atoi(value.c_str()));
+    } else if (arg == "--mst") {
+      options.kruskal = (value == "kruskal" || value == "both");
+      options.boruvka = (value == "boruvka" || value == "both");
+      if (!options.kruskal && !options.boruvka) {
+        std::cerr << "unknown mst backend " << value << std::endl;
+        return false;
+      }
+    } else if (arg == "--split") {
+      options.splits.clear();
+      if (value == "vertical" || value == "both") {
+        options.splits.push_back(SplitStrategy::Vertical);
+      }
+      if (value == "alternating" || value == "both") {
+        options.splits.push_back(SplitStrategy::Alternating);
+      }
+      if (options.splits.empty()) {
+        std::cerr << "unknown split strategy " << value << std::endl;
+        return false;
+      }
+    } else if (arg == "--scalar") {
+      if (value == "all") {
+        options.scalars = {"float", "double", "int32"};
+      } else if (value == "float" || value == "double" || value == "int32") {
+        options.scalars = {value};
+      } else {
+        std::cerr << "unknown scalar " << value << std::endl;
+        return false;
+      }
+    } else if (arg == "--queries") {
+      options.queries = static_cast<size_t>(std::strtod(value.c_str(), nullptr));
+    } else if (arg == "--batch") {
+      options.batch = static_cast<size_t>(std::strtod(value.c_str(), nullptr));
+    } else if (arg == "--predicates") {
+      options.predicates =
+          static_cast<size_t>(std::strtod(value.c_str(), nullptr));
+    } else if (arg == "--json") {
+      options.json = value;
+    } else if (arg == "--trace") {
+      options.trace = value;
+    } else if (arg == "--snapshot") {
+      options.snapshot = value;
+    } else if (arg == "--stream") {
+      options.stream_budget =
+          static_cast<size_t>(std::strtod(value.c_str(), nullptr));
+    } else {
+      std::cerr << "unknown option " << arg << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+/*********************** Distributions *************************************/
+// all in [-1, 1]^2, fixed seed per distribution and size
+
+void uniform(std::mt19937 &gen, size_t n, std::vector<float2> &points) {
+  std::uniform_real_distribution<float> dis(-1.0f, 1.0f);
+  for (size_t i = 0; i < n; i++) {
+    float x = dis(gen);
+    points.emplace_back(x, dis(gen));
+  }
+}
+
+// 16 gaussian blobs of various widths
+void clusters(std::mt19937 &gen, size_t n, std::vector<float2> &points) {
+  const int num_clusters = 16;
+  std::uniform_real_distribution<float> center(-0.8f, 0.8f);
+  std::uniform_real_distribution<float> width(0.005f, 0.05f);
+  std::vector<float2> centers;
+  std::vector<float> widths;
+  for (int c = 0; c < num_clusters; c++) {
+    float x = center(gen);
+    centers.emplace_back(x, center(gen));
+    widths.push_back(width(gen));
+  }
+  std::uniform_int_distribution<int> pick(0, num_clusters - 1);
+  std::normal_distribution<float> normal(0.0f, 1.0f);
+  for (size_t i = 0; i < n; i++) {
+    int c = pick(gen);
+    float x = centers[c].x + widths[c] * normal(gen);
+    points.emplace_back(x, centers[c].y + widths[c] * normal(gen));
+  }
+}
+
+// regular grid moved by 1% of a cell: many almost cocircular quadruples
+void grid(std::mt19937 &gen, size_t n, std::vector<float2> &points) {
+  size_t side = static_cast<size_t>(std::ceil(std::sqrt(double(n))));
+  float cell = 2.0f / std::max<size_t>(side, 1);
+  std::uniform_real_distribution<float> jitter(-0.01f * cell, 0.01f * cell);
+  for (size_t i = 0; i < n; i++) {
+    float x = -1.0f + cell * (i % side) + jitter(gen);
+    points.emplace_back(x, -1.0f + cell * (i / side) + jitter(gen));
+  }
+}
+
+// points a few ulps away from 8 random lines: exact predicates fallbacks
+void lines(std::mt19937 &gen, size_t n, std::vector<float2> &points) {
+  const int num_lines = 8;
+  std::uniform_real_distribution<float> dis(-1.0f, 1.0f);
+  std::vector<float2> from;
+  std::vector<float2> to;
+  for (int l = 0; l < num_lines; l++) {
+    float x = dis(gen);
+    from.emplace_back(x, dis(gen));
+    x = dis(gen);
+    to.emplace_back(x, dis(gen));
+  }
+  std::uniform_int_distribution<int> pick(0, num_lines - 1);
+  std::uniform_real_distribution<float> t(0.0f, 1.0f);
+  std::uniform_real_distribution<float> noise(-1e-6f, 1e-6f);
+  for (size_t i = 0; i < n; i++) {
+    int l = pick(gen);
+    float s = t(gen);
+    float x = from[l].x + s * (to[l].x - from[l].x) + noise(gen);
+    points.emplace_back(x, from[l].y + s * (to[l].y - from[l].y) + noise(gen));
+  }
+}
+
+// n points drawn from n / 10 distinct ones
+void duplicates(std::mt19937 &gen, size_t n, std::vector<float2> &points) {
+  std::vector<float2> pool;
+  uniform(gen, std::max<size_t>(n / 10, 1), pool);
+  std::uniform_int_distribution<size_t> pick(0, pool.size() - 1);
+  for (size_t i = 0; i < n; i++) {
+    points.push_back(pool[pick(gen)]);
+  }
+}
+
+std::vector<float2> generate(const std::string &distribution, size_t n) {
+  std::vector<float2> points;
+  points.reserve(n);
+  std::mt19937 gen(static_cast<unsigned>(5489u + n));
+  if (distribution == "uniform") {
+    uniform(gen, n, points);
+  } else if (distribution == "clusters") {
+    clusters(gen, n, points);
+  } else if (distribution == "grid") {
+    grid(gen, n, points);
+  } else if (distribution == "lines") {
+    lines(gen, n, points);
+  } else {
+    duplicates(gen, n, points);
+  }
+  return points;
+}
+
+/*********************** Measures ******************************************/
+
+// heap allocations of the whole process (operator new replaced below)
+std::atomic<size_t> g_allocations(0);
+
+double seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+// peak resident memory of the process so far, in bytes
+size_t peakRss() {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+  return static_cast<size_t>(usage.ru_maxrss) * 1024; // kilobytes on linux
+}
+
+const char *splitName(SplitStrategy split) {
+  return split == SplitStrategy::Alternating ? "alternating" : "vertical";
+}
+
+// integer coordinates quantize [-1, 1] on a grid of 2^-20 cells
+const double kIntScale = 1 << 20;
+
+// generated points in the coordinates of a case (doubles hold floats exactly)
+template <typename T> Vec2<T> toScalar(const float2 &p) { return Vec2<T>(p); }
+template <> int2 toScalar<int32_t>(const float2 &p) {
+  return int2(static_cast<int32_t>(std::lround(p.x * kIntScale)),
+              static_cast<int32_t>(std::lround(p.y * kIntScale)));
+}
+
+// nearest vertex queries are only implemented for float coordinates
+void timeQueries(const DivideConquer &dc, const std::vector<float2> &queries,
+                 std::vector<int> &nearest, Samples &samples) {
+  DelaunayHierarchy hierarchy;
+  hierarchy.build(dc);
+  auto start = std::chrono::steady_clock::now();
+  hierarchy.nearestVertices(queries.data(), queries.size(), nearest.data());
+  samples.values.push_back(seconds(start));
+}
+template <typename T>
+void timeQueries(const BasicDivideConquer<T> &, const std::vector<float2> &,
+                 std::vector<int> &, Samples &) {}
+
+// saves the triangulation and its tree, then maps the file back
+void timeSnapshot(const std::string &path, DivideConquer &dc,
+                  const std::vector<Edge *> &tree, float min_d, Case &c) {
+  TriangulationMesh mesh;
+  dc.exportMesh(mesh);
+  try {
+    auto start = std::chrono::steady_clock::now();
+    saveSnapshot(path, dc, mesh, tree, min_d);
+    c.snapshot_save.values.push_back(seconds(start));
+    Snapshot snapshot;
+    start = std::chrono::steady_clock::now();
+    snapshot.open(path);
+    c.snapshot_open.values.push_back(seconds(start));
+    c.snapshot_bytes = snapshot.fileSize();
+  } catch (const std::runtime_error &e) {
+    std::cerr << e.what() << std::endl;
+  }
+}
+template <typename T>
+void timeSnapshot(const std::string &, BasicDivideConquer<T> &,
+                  const std::vector<BasicEdge<T> *> &, float, Case &) {}
+
+// temporary file for streamed edges, removed by the caller
+std::string temporaryPath() {
+  const char *dir = std::getenv("TMPDIR");
+  std::string path = std::string(dir ? dir : "/tmp") + "/benchmark_XXXXXX";
+  const int fd = mkstemp(&path[0]);
+  if (fd < 0) {
+    throw std::runtime_error("cannot create a file in " + path);
+  }
+  close(fd);
+  return path;
+}
+
+// streams sorted points through StreamingDelaunay then StreamingMst
+void timeStream(const std::vector<float2> &sorted, size_t budget,
+                Case &c) {
+  try {
+    const std::string path = temporaryPath();
+    auto start = std::chrono::steady_clock::now();
+    {
+      StreamingDelaunay stream(path, budget);
+      stream.addPoints(sorted.data(), sorted.size());
+      stream.finish();
+      c.stream_peak_vertices = stream.peakRetainedVertices();
+    }
+    c.stream_triangulation.values.push_back(seconds(start));
+    start = std::chrono::steady_clock::now();
+    StreamingMst mst;
+    mst.computeMinD(path, "");
+    c.stream_mst.values.push_back(seconds(start));
+    std::remove(path.c_str());
+  } catch (const std::runtime_error &e) {
+    std::cerr << e.what() << std::endl;
+  }
+}
+
+template <typename T>
+Case run(const Options &options, const std::string &distribution,
+         SplitStrategy split, size_t size, const char *scalar) {
+  typedef BasicDivideConquer<T> Triangulation;
+  Case c;
+  c.distribution = distribution;
+  c.scalar = scalar;
+  c.split = split;
+  c.size = size;
+  std::vector<Vec2<T>> points;
+  points.reserve(size);
+  for (const float2 &p : generate(distribution, size)) {
+    points.push_back(toScalar<T>(p));
+  }
+  // the stream wants x-then-y sorted points (sorting is not timed)
+  std::vector<float2> sorted;
+  if (options.stream_budget > 0 && std::strcmp(scalar, "float") == 0) {
+    sorted = generate(distribution, size);
+    std::sort(sorted.begin(), sorted.end(),
+              [](const float2 &a, const float2 &b) {
+                return a.x < b.x || (a.x == b.x && a.y < b.y);
+              });
+  }
+  std::vector<float2> queries;
+  std::mt19937 gen(static_cast<unsigned>(size));
+  uniform(gen, options.queries, queries);
+  std::vector<int> nearest(queries.size());
+
+  // samples do not allocate while allocations are counted
+  for (Samples *s : {&c.preprocess, &c.sort, &c.dedup, &c.triangulation,
+                     &c.reorder, &c.kruskal, &c.boruvka, &c.dendrogram,
+                     &c.query, &c.snapshot_save, &c.snapshot_open,
+                     &c.stream_triangulation, &c.stream_mst}) {
+    s->values.reserve(options.reps);
+  }
+
+  std::vector<typename Triangulation::Edge *> solution;
+  Dendrogram dendrogram;
+  std::unique_ptr<Triangulation> reused;
+  for (int r = 0; r < options.reps; r++) {
+    // fresh object (every repetition pays for its allocations) unless reused
+    std::unique_ptr<Triangulation> fresh;
+    if (!options.reuse || !reused) {
+      fresh.reset(new Triangulation());
+      fresh->setNumThreads(options.threads);
+    }
+    if (options.reuse && !reused) {
+      reused = std::move(fresh);
+    }
+    Triangulation &dc = options.reuse ? *reused : *fresh;
+    size_t allocations = g_allocations;
+    dc.computeTriangulation(points.data(), points.size(), split);
+    c.preprocess.values.push_back(dc.phaseTimes().preprocess);
+    c.sort.values.push_back(dc.phaseTimes().sort);
+    c.dedup.values.push_back(dc.phaseTimes().dedup);
+    c.triangulation.values.push_back(dc.phaseTimes().triangulation);
+
+    if (options.hilbert) {
+      auto start = std::chrono::steady_clock::now();
+      dc.reorderVertices();
+      c.reorder.values.push_back(seconds(start));
+    }
+
+    if (options.kruskal) {
+      solution.clear();
+      dc.setMstBackend(MstBackend::Kruskal);
+      c.min_d = dc.computeMinD(solution);
+      c.kruskal.values.push_back(dc.phaseTimes().mst);
+    }
+    if (options.boruvka) {
+      solution.clear();
+      dc.setMstBackend(MstBackend::Boruvka);
+      c.min_d = dc.computeMinD(solution);
+      c.boruvka.values.push_back(dc.phaseTimes().mst);
+    }
+    c.allocations = g_allocations - allocations;
+    {
+      auto start = std::chrono::steady_clock::now();
+      dendrogram.build(solution, dc.orderedPoints().size());
+      c.dendrogram.values.push_back(seconds(start));
+    }
+
+    if (!queries.empty()) {
+      timeQueries(dc, queries, nearest, c.query);
+    }
+    if (!options.snapshot.empty()) {
+      timeSnapshot(options.snapshot, dc, solution, c.min_d, c);
+    }
+    if (!sorted.empty()) {
+      timeStream(sorted, options.stream_budget, c);
+    }
+
+    c.num_vertices = dc.orderedPoints().size();
+    c.num_edges = dc.numEdges();
+    c.num_deleted_edges = dc.numDeletedEdges();
+    c.edge_bytes = dc.edgeBytes();
+    c.stats = dc.stats();
+  }
+  c.peak_rss = peakRss();
+  return c;
+}
+
+BatchCase runBatch(const Options &options) {
+  BatchCase b;
+  b.systems = options.batch;
+  // log-uniform sizes, distributions in turn
+  std::mt19937 gen(1234u);
+  std::uniform_real_distribution<double> exponent(3.0, 5.0);
+  std::vector<std::vector<float2>> sets;
+  std::vector<PointSet> systems;
+  for (size_t s = 0; s < options.batch; s++) {
+    size_t size = static_cast<size_t>(std::pow(10.0, exponent(gen)));
+    sets.push_back(generate(
+        options.distributions[s % options.distributions.size()], size));
+    b.points += size;
+  }
+  for (const std::vector<float2> &set : sets) {
+    systems.push_back(PointSet{set.data(), set.size()});
+  }
+
+  BatchTriangulator batch(options.threads);
+  batch.setMstBackend(options.kruskal ? MstBackend::Kruskal
+                                      : MstBackend::Boruvka);
+  batch.setSplitStrategy(options.splits.front());
+  std::vector<SystemResult> results;
+  for (int r = 0; r < options.reps; r++) {
+    auto start = std::chrono::steady_clock::now();
+    batch.run(systems, results);
+    b.run.values.push_back(seconds(start));
+  }
+  return b;
+}
+
+/*********************** Batch predicates **********************************/
+// In-circle and orientation tests filtered 4 at a time, timed against the
+// library predicates by --predicates. Not used by the triangulation: merges
+// test one candidate at a time, and gathering lanes there was measured 15 to
+// 25% slower.
+
+// orientation uses kCcwErrBound of predicates.h. Lifted in-circle form:
+// differences of lifts (3 roundings each) replace squares of differences,
+// the terms of the permanent being |la| + |ld| and so on
+const double kLiftedIccErrBound =
+    (16.0 + 256.0 * kPredicateEpsilon) * kPredicateEpsilon;
+
+/*!
+ * \brief Operands of several in-circle tests, one per lane
+ *
+ * Structure of arrays: lane i tests point d against the circle through
+ * counterclockwise (a, b, c). Points come with their lifted coordinate
+ * l = x * x + y * y, evaluated in double: the determinant is then formed
+ * from differences of lifts instead of squares of differences. Lanes past
+ * the count of a call are ignored.
+ */
+struct alignas(32) IncircleBatch {
+  static const int kLanes = 4;
+  double ax[kLanes], ay[kLanes], al[kLanes];
+  double bx[kLanes], by[kLanes], bl[kLanes];
+  double cx[kLanes], cy[kLanes], cl[kLanes];
+  double dx[kLanes], dy[kLanes], dl[kLanes];
+};
+
+// operands of several orientation tests: lane i tests (a, b, c)
+struct alignas(32) OrientBatch {
+  static const int kLanes = 4;
+  double ax[kLanes], ay[kLanes];
+  double bx[kLanes], by[kLanes];
+  double cx[kLanes], cy[kLanes];
+};
+
+// lanes the filter cannot decide go through the library predicates
+int incircleLane(const IncircleBatch &b, int i) {
+  double det = incircle(b.ax[i], b.ay[i], b.bx[i], b.by[i], b.cx[i], b.cy[i],
+                        b.dx[i], b.dy[i]);
+  return (det > 0) - (det < 0);
+}
+
+int orientLane(const OrientBatch &b, int i) {
+  double det = orient2d(b.ax[i], b.ay[i], b.bx[i], b.by[i], b.cx[i], b.cy[i]);
+  return (det > 0) - (det < 0);
+}
+
+// signs of lanes from the filter masks (bit i: lane i is surely positive,
+// surely negative), undecided lanes evaluated one at a time
+template <typename Batch, typename Exact>
+void resolveLanes(const Batch &b, int num_lanes, int positive, int negative,
+                  int *signs, Exact exact) {
+  for (int i = 0; i < num_lanes; i++) {
+    if (positive >> i & 1) {
+      signs[i] = 1;
+    } else if (negative >> i & 1) {
+      signs[i] = -1;
+    } else {
+      signs[i] = exact(b, i);
+    }
+  }
+}
+
+void incircleScalar(const IncircleBatch &b, int num_lanes, int *signs) {
+  for (int i = 0; i < num_lanes; i++) {
+    double adx = b.ax[i] - b.dx[i];
+    double bdx = b.bx[i] - b.dx[i];
+    double cdx = b.cx[i] - b.dx[i];
+    double ady = b.ay[i] - b.dy[i];
+    double bdy = b.by[i] - b.dy[i];
+    double cdy = b.cy[i] - b.dy[i];
+    double alift = b.al[i] - b.dl[i];
+    double blift = b.bl[i] - b.dl[i];
+    double clift = b.cl[i] - b.dl[i];
+
+    double bdxcdy = bdx * cdy;
+    double cdxbdy = cdx * bdy;
+    double cdxady = cdx * ady;
+    double adxcdy = adx * cdy;
+    double adxbdy = adx * bdy;
+    double bdxady = bdx * ady;
+    double det = alift * (bdxcdy - cdxbdy) + blift * (cdxady - adxcdy) +
+                 clift * (adxbdy - bdxady);
+
+    // lifts are not negative
+    double permanent =
+        (std::fabs(bdxcdy) + std::fabs(cdxbdy)) * (b.al[i] + b.dl[i]) +
+        (std::fabs(cdxady) + std::fabs(adxcdy)) * (b.bl[i] + b.dl[i]) +
+        (std::fabs(adxbdy) + std::fabs(bdxady)) * (b.cl[i] + b.dl[i]);
+    double errbound = kLiftedIccErrBound * permanent;
+    if (det > errbound || -det > errbound) {
+      signs[i] = det > 0 ? 1 : -1;
+    } else {
+      signs[i] = incircleLane(b, i);
+    }
+  }
+}
+
+void orientScalar(const OrientBatch &b, int num_lanes, int *signs) {
+  for (int i = 0; i < num_lanes; i++) {
+    double det = orient2d(b.ax[i], b.ay[i], b.bx[i], b.by[i], b.cx[i],
+                          b.cy[i]);
+    signs[i] = (det > 0) - (det < 0);
+  }
+}
+
+#ifdef BENCHMARK_X86
+// both kernels follow incircleScalar and orientScalar operation by
+// operation, on 2 (SSE2) or 4 (AVX2) lanes
+void incircleSse2(const IncircleBatch &b, int num_lanes, int *signs) {
+  const __m128d abs_mask = _mm_castsi128_pd(_mm_set1_epi64x(INT64_MAX));
+  const __m128d bound = _mm_set1_pd(kLiftedIccErrBound);
+  int positive = 0;
+  int negative = 0;
+  for (int i = 0; i < num_lanes; i += 2) {
+    __m128d dx = _mm_loadu_pd(b.dx + i);
+    __m128d dy = _mm_loadu_pd(b.dy + i);
+    __m128d dl = _mm_loadu_pd(b.dl + i);
+    __m128d al = _mm_loadu_pd(b.al + i);
+    __m128d bl = _mm_loadu_pd(b.bl + i);
+    __m128d cl = _mm_loadu_pd(b.cl + i);
+    __m128d adx = _mm_sub_pd(_mm_loadu_pd(b.ax + i), dx);
+    __m128d bdx = _mm_sub_pd(_mm_loadu_pd(b.bx + i), dx);
+    __m128d cdx = _mm_sub_pd(_mm_loadu_pd(b.cx + i), dx);
+    __m128d ady = _mm_sub_pd(_mm_loadu_pd(b.ay + i), dy);
+    __m128d bdy = _mm_sub_pd(_mm_loadu_pd(b.by + i), dy);
+    __m128d cdy = _mm_sub_pd(_mm_loadu_pd(b.cy + i), dy);
+
+    __m128d bdxcdy = _mm_mul_pd(bdx, cdy);
+    __m128d cdxbdy = _mm_mul_pd(cdx, bdy);
+    __m128d cdxady = _mm_mul_pd(cdx, ady);
+    __m128d adxcdy = _mm_mul_pd(adx, cdy);
+    __m128d adxbdy = _mm_mul_pd(adx, bdy);
+    __m128d bdxady = _mm_mul_pd(bdx, ady);
+    __m128d det = _mm_add_pd(
+        _mm_add_pd(
+            _mm_mul_pd(_mm_sub_pd(al, dl), _mm_sub_pd(bdxcdy, cdxbdy)),
+            _mm_mul_pd(_mm_sub_pd(bl, dl), _mm_sub_pd(cdxady, adxcdy))),
+        _mm_mul_pd(_mm_sub_pd(cl, dl), _mm_sub_pd(adxbdy, bdxady)));
+
+    __m128d permanent = _mm_add_pd(
+        _mm_add_pd(_mm_mul_pd(_mm_add_pd(_mm_and_pd(bdxcdy, abs_mask),
+                                         _mm_and_pd(cdxbdy, abs_mask)),
+                              _mm_add_pd(al, dl)),
+                   _mm_mul_pd(_mm_add_pd(_mm_and_pd(cdxady, abs_mask),
+                                         _mm_and_pd(adxcdy, abs_mask)),
+                              _mm_add_pd(bl, dl))),
+        _mm_mul_pd(_mm_add_pd(_mm_and_pd(adxbdy, abs_mask),
+                              _mm_and_pd(bdxady, abs_mask)),
+                   _mm_add_pd(cl, dl)));
+    __m128d errbound = _mm_mul_pd(bound, permanent);
+    positive |= _mm_movemask_pd(_mm_cmpgt_pd(det, errbound)) << i;
+    negative |= _mm_movemask_pd(
+                    _mm_cmpgt_pd(_mm_sub_pd(_mm_setzero_pd(), det), errbound))
+                << i;
+  }
+  resolveLanes(b, num_lanes, positive, negative, signs, incircleLane);
+}
+
+__attribute__((target("avx2"))) void
+incircleAvx2(const IncircleBatch &b, int num_lanes, int *signs) {
+  const __m256d abs_mask = _mm256_castsi256_pd(_mm256_set1_epi64x(INT64_MAX));
+  __m256d dx = _mm256_loadu_pd(b.dx);
+  __m256d dy = _mm256_loadu_pd(b.dy);
+  __m256d dl = _mm256_loadu_pd(b.dl);
+  __m256d al = _mm256_loadu_pd(b.al);
+  __m256d bl = _mm256_loadu_pd(b.bl);
+  __m256d cl = _mm256_loadu_pd(b.cl);
+  __m256d adx = _mm256_sub_pd(_mm256_loadu_pd(b.ax), dx);
+  __m256d bdx = _mm256_sub_pd(_mm256_loadu_pd(b.bx), dx);
+  __m256d cdx = _mm256_sub_pd(_mm256_loadu_pd(b.cx), dx);
+  __m256d ady = _mm256_sub_pd(_mm256_loadu_pd(b.ay), dy);
+  __m256d bdy = _mm256_sub_pd(_mm256_loadu_pd(b.by), dy);
+  __m256d cdy = _mm256_sub_pd(_mm256_loadu_pd(b.cy), dy);
+
+  __m256d bdxcdy = _mm256_mul_pd(bdx, cdy);
+  __m256d cdxbdy = _mm256_mul_pd(cdx, bdy);
+  __m256d cdxady = _mm256_mul_pd(cdx, ady);
+  __m256d adxcdy = _mm256_mul_pd(adx, cdy);
+  __m256d adxbdy = _mm256_mul_pd(adx, bdy);
+  __m256d bdxady = _mm256_mul_pd(bdx, ady);
+  __m256d det = _mm256_add_pd(
+      _mm256_add_pd(_mm256_mul_pd(_mm256_sub_pd(al, dl),
+                                  _mm256_sub_pd(bdxcdy, cdxbdy)),
+                    _mm256_mul_pd(_mm256_sub_pd(bl, dl),
+                                  _mm256_sub_pd(cdxady, adxcdy))),
+      _mm256_mul_pd(_mm256_sub_pd(cl, dl), _mm256_sub_pd(adxbdy, bdxady)));
+
+  __m256d permanent = _mm256_add_pd(
+      _mm256_add_pd(
+          _mm256_mul_pd(_mm256_add_pd(_mm256_and_pd(bdxcdy, abs_mask),
+                                      _mm256_and_pd(cdxbdy, abs_mask)),
+                        _mm256_add_pd(al, dl)),
+          _mm256_mul_pd(_mm256_add_pd(_mm256_and_pd(cdxady, abs_mask),
+                                      _mm256_and_pd(adxcdy, abs_mask)),
+                        _mm256_add_pd(bl, dl))),
+      _mm256_mul_pd(_mm256_add_pd(_mm256_and_pd(adxbdy, abs_mask),
+                                  _mm256_and_pd(bdxady, abs_mask)),
+                    _mm256_add_pd(cl, dl)));
+  __m256d errbound =
+      _mm256_mul_pd(_mm256_set1_pd(kLiftedIccErrBound), permanent);
+  int positive =
+      _mm256_movemask_pd(_mm256_cmp_pd(det, errbound, _CMP_GT_OQ));
+  int negative = _mm256_movemask_pd(_mm256_cmp_pd(
+      _mm256_sub_pd(_mm256_setzero_pd(), det), errbound, _CMP_GT_OQ));
+  resolveLanes(b, num_lanes, positive, negative, signs, incircleLane);
+}
+
+void orientSse2(const OrientBatch &b, int num_lanes, int *signs) {
+  const __m128d abs_mask = _mm_castsi128_pd(_mm_set1_epi64x(INT64_MAX));
+  const __m128d bound = _mm_set1_pd(kCcwErrBound);
+  int positive = 0;
+  int negative = 0;
+  for (int i = 0; i < num_lanes; i += 2) {
+    __m128d cx = _mm_loadu_pd(b.cx + i);
+    __m128d cy = _mm_loadu_pd(b.cy + i);
+    __m128d detleft = _mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(b.ax + i), cx),
+                                 _mm_sub_pd(_mm_loadu_pd(b.by + i), cy));
+    __m128d detright = _mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(b.ay + i), cy),
+                                  _mm_sub_pd(_mm_loadu_pd(b.bx + i), cx));
+    __m128d det = _mm_sub_pd(detleft, detright);
+    __m128d errbound =
+        _mm_mul_pd(bound, _mm_add_pd(_mm_and_pd(detleft, abs_mask),
+                                     _mm_and_pd(detright, abs_mask)));
+    positive |= _mm_movemask_pd(_mm_cmpgt_pd(det, errbound)) << i;
+    negative |= _mm_movemask_pd(
+                    _mm_cmpgt_pd(_mm_sub_pd(_mm_setzero_pd(), det), errbound))
+                << i;
+  }
+  resolveLanes(b, num_lanes, positive, negative, signs, orientLane);
+}
+
+__attribute__((target("avx2"))) void
+orientAvx2(const OrientBatch &b, int num_lanes, int *signs) {
+  const __m256d abs_mask = _mm256_castsi256_pd(_mm256_set1_epi64x(INT64_MAX));
+  __m256d cx = _mm256_loadu_pd(b.cx);
+  __m256d cy = _mm256_loadu_pd(b.cy);
+  __m256d detleft = _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(b.ax), cx),
+                                  _mm256_sub_pd(_mm256_loadu_pd(b.by), cy));
+  __m256d detright = _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(b.ay), cy),
+                                   _mm256_sub_pd(_mm256_loadu_pd(b.bx), cx));
+  __m256d det = _mm256_sub_pd(detleft, detright);
+  __m256d errbound = _mm256_mul_pd(
+      _mm256_set1_pd(kCcwErrBound),
+      _mm256_add_pd(_mm256_and_pd(detleft, abs_mask),
+                    _mm256_and_pd(detright, abs_mask)));
+  int positive =
+      _mm256_movemask_pd(_mm256_cmp_pd(det, errbound, _CMP_GT_OQ));
+  int negative = _mm256_movemask_pd(_mm256_cmp_pd(
+      _mm256_sub_pd(_mm256_setzero_pd(), det), errbound, _CMP_GT_OQ));
+  resolveLanes(b, num_lanes, positive, negative, signs, orientLane);
+}
+
+bool hasAvx2() { return __builtin_cpu_supports("avx2"); }
+#endif
+
+bool always() { return true; }
+
+struct BatchKernel {
+  const char *name;
+  void (*incircle)(const IncircleBatch &, int, int *);
+  void (*orient)(const OrientBatch &, int, int *);
+  bool (*supported)();
+};
+
+// fastest first, each timed if the CPU supports it
+const BatchKernel kBatchKernels[] = {
+#ifdef BENCHMARK_X86
+    {"avx2", incircleAvx2, orientAvx2, hasAvx2},
+    {"sse2", incircleSse2, orientSse2, always},
+#endif
+    {"scalar", incircleScalar, orientScalar, always},
+};
+
+std::vector<PredicateCase> runPredicates(const Options &options) {
+  // quadruples of consecutive points in x order (close to each other, like
+  // the ones of merges), distributions in turn. Lifts are computed once.
+  const size_t n = options.predicates;
+  const size_t num_dists = options.distributions.size();
+  std::vector<double> x(4 * n), y(4 * n), lifted(4 * n);
+  for (size_t d = 0; d < num_dists; d++) {
+    std::vector<float2> points =
+        generate(options.distributions[d], 4 * (n / num_dists + 1));
+    std::sort(points.begin(), points.end(),
+              [](const float2 &a, const float2 &b) { return a.x < b.x; });
+    for (size_t t = d; t < n; t += num_dists) {
+      for (size_t k = 0; k < 4; k++) {
+        const float2 &p = points[4 * (t / num_dists) + k];
+        x[4 * t + k] = p.x;
+        y[4 * t + k] = p.y;
+        lifted[4 * t + k] = double(p.x) * p.x + double(p.y) * p.y;
+      }
+    }
+  }
+  const int kLanes = IncircleBatch::kLanes;
+  std::vector<IncircleBatch> incircles((n + kLanes - 1) / kLanes);
+  std::vector<OrientBatch> orients(incircles.size());
+  for (size_t t = 0; t < n; t++) {
+    IncircleBatch &b = incircles[t / kLanes];
+    OrientBatch &o = orients[t / kLanes];
+    const size_t l = t % kLanes;
+    const size_t i = 4 * t;
+    b.ax[l] = o.ax[l] = x[i];
+    b.ay[l] = o.ay[l] = y[i];
+    b.bx[l] = o.bx[l] = x[i + 1];
+    b.by[l] = o.by[l] = y[i + 1];
+    b.cx[l] = o.cx[l] = x[i + 2];
+    b.cy[l] = o.cy[l] = y[i + 2];
+    b.dx[l] = x[i + 3];
+    b.dy[l] = y[i + 3];
+    b.al[l] = lifted[i];
+    b.bl[l] = lifted[i + 1];
+    b.cl[l] = lifted[i + 2];
+    b.dl[l] = lifted[i + 3];
+  }
+
+  // counts of positive signs keep the tests from being optimized out
+  volatile size_t positives = 0;
+  std::vector<PredicateCase> cases(1);
+  cases[0].kernel = "single";
+  for (int r = 0; r < options.reps; r++) {
+    size_t count = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < 4 * n; i += 4) {
+      count += incircle(x[i], y[i], x[i + 1], y[i + 1], x[i + 2], y[i + 2],
+                        x[i + 3], y[i + 3]) > 0;
+    }
+    cases[0].incircle.values.push_back(seconds(start));
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < 4 * n; i += 4) {
+      count += orient2d(x[i], y[i], x[i + 1], y[i + 1], x[i + 2], y[i + 2]) >
+               0;
+    }
+    cases[0].orient.values.push_back(seconds(start));
+    positives = positives + count;
+  }
+
+  for (const BatchKernel &kernel : kBatchKernels) {
+    if (!kernel.supported()) {
+      continue;
+    }
+    PredicateCase c;
+    c.kernel = kernel.name;
+    int signs[kLanes];
+    for (int r = 0; r < options.reps; r++) {
+      size_t count = 0;
+      auto start = std::chrono::steady_clock::now();
+      for (size_t b = 0; b < incircles.size(); b++) {
+        const int num_lanes = static_cast<int>(
+            std::min<size_t>(kLanes, n - b * kLanes));
+        kernel.incircle(incircles[b], num_lanes, signs);
+        count += signs[0] > 0;
+      }
+      c.incircle.values.push_back(seconds(start));
+      start = std::chrono::steady_clock::now();
+      for (size_t b = 0; b < orients.size(); b++) {
+        const int num_lanes = static_cast<int>(
+            std::min<size_t>(kLanes, n - b * kLanes));
+        kernel.orient(orients[b], num_lanes, signs);
+        count += signs[0] > 0;
+      }
+      c.orient.values.push_back(seconds(start));
+      positives = positives + count;
+    }
+    cases.push_back(c);
+  }
+  return cases;
+}
+
+double edgesPerSecond(const Case &c) {
+  double median = c.triangulation.percentile(0.5);
+  return median > 0 ? c.num_edges / median : 0.0;
+}
+
+/*********************** Checks ********************************************/
+// brute force validation on small inputs (--check), nothing timed
+
+// vertices of a computed triangulation not sorted (strictly) x-then-y
+template <typename T> size_t checkSorted(const BasicDivideConquer<T> &dc) {
+  const std::vector<Vec2<T>> &points = dc.orderedPoints();
+  size_t failures = 0;
+  for (size_t i = 1; i < points.size(); i++) {
+    failures += !(points[i - 1].x < points[i].x ||
+                  (points[i - 1].x == points[i].x &&
+                   points[i - 1].y < points[i].y));
+  }
+  return failures;
+}
+
+// failures of the triangulation of dc: triangles not counterclockwise or
+// with a vertex inside their circle, number of triangles not the one of
+// Euler's formula. Removed vertices are left out.
+template <typename T>
+size_t checkDelaunay(BasicDivideConquer<T> &dc) {
+  const std::vector<Vec2<T>> &points = dc.orderedPoints();
+  size_t failures = 0;
+  size_t num_live = 0;
+  for (size_t i = 0; i < points.size(); i++) {
+    num_live += !dc.isRemoved(static_cast<int>(i));
+  }
+  TriangulationMesh mesh;
+  dc.exportMesh(mesh);
+  for (size_t t = 0; t < mesh.numTriangles(); t++) {
+    const Vec2<T> &a = points[mesh.triangles[3 * t]];
+    const Vec2<T> &b = points[mesh.triangles[3 * t + 1]];
+    const Vec2<T> &c = points[mesh.triangles[3 * t + 2]];
+    failures += !ccw(a, b, c);
+    for (size_t i = 0; i < points.size(); i++) {
+      failures += !dc.isRemoved(static_cast<int>(i)) &&
+                  insideCircle(points[i], a, b, c);
+    }
+  }
+  // collinear vertices have no triangle
+  if (mesh.numTriangles() > 0 &&
+      mesh.numTriangles() + 2 + mesh.hull.size() != 2 * num_live) {
+    failures++;
+  }
+  return failures;
+}
+
+// generated distributions in each coordinate type
+template <typename T> size_t checkDistributions(const char *scalar) {
+  size_t failures = 0;
+  for (const char *distribution : kDistributions) {
+    std::vector<Vec2<T>> points;
+    for (const float2 &p : generate(distribution, 500)) {
+      points.push_back(toScalar<T>(p));
+    }
+    BasicDivideConquer<T> dc;
+    dc.computeTriangulation(points);
+    const size_t f = checkSorted(dc) + checkDelaunay(dc);
+    if (f > 0) {
+      std::cerr << "check " << distribution << " " << scalar << ": " << f
+                << " failures" << std::endl;
+    }
+    failures += f;
+  }
+  return failures;
+}
+
+// doubles a few float ulps apart: distinct x round to the same float, which
+// the sort keys are made of
+size_t checkCloseDoubles() {
+  size_t failures = 0;
+  for (unsigned seed = 1; seed <= 8; seed++) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> dis(0.0, 3.6e-7);
+    std::vector<double2> points;
+    for (int i = 0; i < 300; i++) {
+      double x = 1.0 + dis(gen);
+      points.emplace_back(x, 1.0 + dis(gen));
+    }
+    // and a few exact duplicates
+    for (int i = 0; i < 30; i++) {
+      points.push_back(points[gen() % points.size()]);
+    }
+    BasicDivideConquer<double> dc;
+    dc.computeTriangulation(points);
+    size_t f = checkSorted(dc) + checkDelaunay(dc);
+    f += dc.orderedPoints().size() != 300; // duplicates merged, only them
+    if (f > 0) {
+      std::cerr << "check close doubles, seed " << seed << ": " << f
+                << " failures" << std::endl;
+    }
+    failures += f;
+  }
+  return failures;
+}
+
+// nearest vertex queries after every other vertex was removed: removed
+// vertices stay in orderedPoints() but must never be answered
+size_t checkQueriesAfterRemove() {
+  size_t failures = 0;
+  for (size_t size : {50, 20000}) {
+    DivideConquer dc;
+    dc.computeTriangulation(generate("uniform", size));
+    const std::vector<float2> &points = dc.orderedPoints();
+    for (size_t v = 0; v < points.size(); v += 2) {
+      dc.remove(static_cast<int>(v));
+    }
+    DelaunayHierarchy hierarchy;
+    hierarchy.build(dc);
+    std::vector<float2> queries;
+    std::mt19937 gen(static_cast<unsigned>(size));
+    uniform(gen, 2000, queries);
+    size_t f = 0;
+    for (const float2 &q : queries) {
+      const int v = hierarchy.nearestVertex(q);
+      double best = -1;
+      for (size_t i = 1; i < points.size(); i += 2) {
+        const double dx = double(points[i].x) - q.x;
+        const double dy = double(points[i].y) - q.y;
+        if (best < 0 || dx * dx + dy * dy < best) {
+          best = dx * dx + dy * dy;
+        }
+      }
+      const double dx = double(points[v].x) - q.x;
+      const double dy = double(points[v].y) - q.y;
+      f += dc.isRemoved(v) || dx * dx + dy * dy != best;
+    }
+    f += checkDelaunay(dc);
+    if (f > 0) {
+      std::cerr << "check queries after remove, " << size << " points: " << f
+                << " failures" << std::endl;
+    }
+    failures += f;
+  }
+  return failures;
+}
+
+// points inserted one by one, among them copies of vertices and points one
+// float ulp away from vertices: same vertices as a triangulation of all of
+// them at once (duplicates are equal coordinates on both paths)
+size_t checkInsertDuplicates() {
+  size_t failures = 0;
+  for (const char *distribution : {"uniform", "lines"}) {
+    const std::vector<float2> initial = generate(distribution, 1000);
+    std::vector<float2> all = initial;
+    DivideConquer dc;
+    dc.computeTriangulation(initial);
+    std::mt19937 gen(7u);
+    size_t f = 0;
+    for (int i = 0; i < 500; i++) {
+      const float2 &q = all[gen() % all.size()];
+      float2 p = q;
+      if (i % 2 == 1) {
+        p.x = std::nextafter(q.x, 2.0f);
+      }
+      const int before = static_cast<int>(dc.orderedPoints().size());
+      const int v = dc.insert(p);
+      const float2 &w = dc.orderedPoints()[v];
+      f += w.x != p.x || w.y != p.y || (i % 2 == 0 && v == before);
+      all.push_back(p);
+    }
+    DivideConquer all_at_once;
+    all_at_once.computeTriangulation(all);
+    f += dc.orderedPoints().size() != all_at_once.orderedPoints().size();
+    f += checkDelaunay(dc);
+    if (f > 0) {
+      std::cerr << "check insert duplicates, " << distribution << ": " << f
+                << " failures" << std::endl;
+    }
+    failures += f;
+  }
+  return failures;
+}
+
+// edges of a streamed file, as (lower id, higher id)
+void readStreamEdges(const std::string &path,
+                     std::vector<std::pair<uint64_t, uint64_t>> &edges) {
+  std::ifstream in(path, std::ios::binary);
+  StreamBlockHeader header;
+  while (in.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+    std::vector<StreamEdge> block(header.num_edges);
+    in.read(reinterpret_cast<char *>(block.data()),
+            block.size() * sizeof(StreamEdge));
+    in.ignore(header.num_closed * sizeof(uint64_t));
+    for (const StreamEdge &e : block) {
+      edges.emplace_back(std::min(e.u, e.v), std::max(e.u, e.v));
+    }
+  }
+  std::sort(edges.begin(), edges.end());
+}
+
+// out-of-core triangulation and spanning tree with a budget of a few
+// strips: same edges and min_d as in memory. Ids of both are ranks of the
+// distinct points in x-then-y order.
+size_t checkStreaming() {
+  size_t failures = 0;
+  const std::string path = temporaryPath();
+  for (const char *distribution : {"uniform", "grid", "lines"}) {
+    for (size_t size : {0, 1, 2, 3, 5000}) {
+      std::vector<float2> points = generate(distribution, size);
+      std::sort(points.begin(), points.end(),
+                [](const float2 &a, const float2 &b) {
+                  return a.x < b.x || (a.x == b.x && a.y < b.y);
+                });
+      StreamingDelaunay stream(path, 0); // smallest strips
+      stream.addPoints(points.data(), points.size());
+      stream.finish();
+      StreamingMst mst;
+      const float min_d = mst.computeMinD(path, "");
+      std::vector<std::pair<uint64_t, uint64_t>> streamed;
+      readStreamEdges(path, streamed);
+
+      DivideConquer dc;
+      dc.computeTriangulation(points);
+      TriangulationMesh mesh;
+      dc.exportMesh(mesh);
+      std::vector<std::pair<uint64_t, uint64_t>> expected;
+      for (uint32_t v = 0; v + 1 < mesh.offsets.size(); v++) {
+        for (uint32_t i = mesh.offsets[v]; i < mesh.offsets[v + 1]; i++) {
+          if (v < mesh.neighbours[i]) {
+            expected.emplace_back(v, mesh.neighbours[i]);
+          }
+        }
+      }
+      std::sort(expected.begin(), expected.end());
+      std::vector<Edge *> tree;
+      const float expected_min_d = dc.computeMinD(tree);
+
+      size_t f = streamed != expected;
+      f += min_d != expected_min_d;
+      f += mst.numTreeEdges() != tree.size();
+      f += stream.numVertices() != dc.orderedPoints().size();
+      if (f > 0) {
+        std::cerr << "check streaming " << distribution << ", " << size
+                  << " points: " << streamed.size() << " edges for "
+                  << expected.size() << ", min_d " << min_d << " for "
+                  << expected_min_d << std::endl;
+      }
+      failures += f;
+    }
+  }
+  std::remove(path.c_str());
+  return failures;
+}
+
+// quadruples (a, b, c, d) close to the filter bounds: points of a small
+// grid, cocircular points (radius 5) and collinear points, some moved by
+// one ulp, and (12, 12), (24, 24), (0.5, 0.5), (0.5, 0.5) with the last two
+// moved by up to 63 ulps (differences round: the double determinants get
+// wrong signs), near the origin and far from it
+std::vector<double2> batchQuadruples() {
+  static const int kCircle[12][2] = {{5, 0},   {4, 3},  {3, 4},  {0, 5},
+                                     {-3, 4},  {-4, 3}, {-5, 0}, {-4, -3},
+                                     {-3, -4}, {0, -5}, {3, -4}, {4, -3}};
+  static const double kLine[4] = {12.0, 24.0, 0.5, 0.5};
+  std::mt19937 gen(11u);
+  auto moveUlps = [&gen](double v) {
+    for (int k = gen() % 64; k > 0; k--) {
+      v = std::nextafter(v, HUGE_VAL);
+    }
+    return v;
+  };
+  std::vector<double2> quads;
+  for (double offset : {0.0, 1024.0, 6.7e7, -3.0e9}) {
+    for (int family = 0; family < 4; family++) {
+      for (int i = 0; i < 4 * 500; i++) {
+        double x, y;
+        if (family == 0) {
+          x = gen() % 5;
+          y = gen() % 5;
+        } else if (family == 1) {
+          const int *p = kCircle[gen() % 12];
+          x = p[0];
+          y = p[1];
+        } else if (family == 2) {
+          x = gen() % 16;
+          y = 2 * x + 1;
+        } else {
+          x = y = kLine[i % 4];
+        }
+        x += offset;
+        y += offset;
+        if (family == 3 && kLine[i % 4] == 0.5) {
+          x = moveUlps(x);
+          y = moveUlps(y);
+        } else if (family < 3 && gen() % 4 == 0) {
+          x = std::nextafter(x, gen() % 2 ? HUGE_VAL : -HUGE_VAL);
+        }
+        quads.emplace_back(x, y);
+      }
+    }
+  }
+  return quads;
+}
+
+// every lane of the batch kernels has the sign of incircle and orient2d,
+// calls passing 1 to kLanes lanes in turn
+size_t checkBatchKernels() {
+  const std::vector<double2> quads = batchQuadruples();
+  const int kLanes = IncircleBatch::kLanes;
+  size_t failures = 0;
+  for (const BatchKernel &kernel : kBatchKernels) {
+    if (!kernel.supported()) {
+      continue;
+    }
+    size_t f = 0;
+    for (size_t q = 0; q + 4 * kLanes <= quads.size(); q += 4 * kLanes) {
+      IncircleBatch b = IncircleBatch();
+      OrientBatch o = OrientBatch();
+      for (int l = 0; l < kLanes; l++) {
+        const double2 *p = &quads[q + 4 * l];
+        b.ax[l] = o.ax[l] = p[0].x;
+        b.ay[l] = o.ay[l] = p[0].y;
+        b.bx[l] = o.bx[l] = p[1].x;
+        b.by[l] = o.by[l] = p[1].y;
+        b.cx[l] = o.cx[l] = p[2].x;
+        b.cy[l] = o.cy[l] = p[2].y;
+        b.dx[l] = p[3].x;
+        b.dy[l] = p[3].y;
+        b.al[l] = p[0].x * p[0].x + p[0].y * p[0].y;
+        b.bl[l] = p[1].x * p[1].x + p[1].y * p[1].y;
+        b.cl[l] = p[2].x * p[2].x + p[2].y * p[2].y;
+        b.dl[l] = p[3].x * p[3].x + p[3].y * p[3].y;
+      }
+      const int num_lanes = 1 + static_cast<int>(q / (4 * kLanes) % kLanes);
+      int signs[kLanes];
+      kernel.incircle(b, num_lanes, signs);
+      for (int l = 0; l < num_lanes; l++) {
+        f += signs[l] != incircleLane(b, l);
+      }
+      kernel.orient(o, num_lanes, signs);
+      for (int l = 0; l < num_lanes; l++) {
+        f += signs[l] != orientLane(o, l);
+      }
+    }
+    if (f > 0) {
+      std::cerr << "check batch predicates " << kernel.name << ": " << f
+                << " failures" << std::endl;
+    }
+    failures += f;
+  }
+  return failures;
+}
+
+// all checks, number of failures
+size_t runChecks() {
+  size_t failures = checkDistributions<float>("float");
+  failures += checkDistributions<double>("double");
+  failures += checkDistributions<int32_t>("int32");
+  failures += checkCloseDoubles();
+  failures += checkQueriesAfterRemove();
+  failures += checkInsertDuplicates();
+  failures += checkStreaming();
+  failures += checkBatchKernels();
+  return failures;
+}
+
+/*********************** Reports *******************************************/
+
+void printHeader(std::ostream &out) {
+  out << std::left << std::setw(11) << "dist" << std::setw(7) << "scalar"
+            << std::setw(12) << "split"
+            << std::right
+            << std::setw(10) << "points" << std::setw(10) << "vertices"
+            << std::setw(12) << "sort ms" << std::setw(12) << "triang ms"
+            << std::setw(12) << "kruskal ms" << std::setw(12) << "boruvka ms"
+            << std::setw(12) << "query ms"
+            << std::setw(12) << "Medges/s" << std::setw(11) << "edges MB"
+            << std::setw(11) << "rss MB" << std::setw(9) << "allocs"
+            << std::endl;
+}
+
+void printCase(std::ostream &out, const Case &c) {
+  auto ms = [](const Samples &s) {
+    std::ostringstream out;
+    if (s.values.empty()) {
+      out << "-";
+    } else {
+      out << std::fixed << std::setprecision(2) << s.percentile(0.5) * 1e3;
+    }
+    return out.str();
+  };
+  const double mb = 1024.0 * 1024.0;
+  out << std::left << std::setw(11) << c.distribution << std::setw(7)
+            << c.scalar << std::setw(12) << splitName(c.split) << std::right
+            << std::setw(10) << c.size << std::setw(10) << c.num_vertices
+            << std::setw(12) << ms(c.preprocess) << std::setw(12)
+            << ms(c.triangulation) << std::setw(12) << ms(c.kruskal)
+            << std::setw(12) << ms(c.boruvka) << std::setw(12)
+            << ms(c.query) << std::fixed
+            << std::setprecision(2) << std::setw(12)
+            << edgesPerSecond(c) / 1e6 << std::setw(11)
+            << c.edge_bytes / mb << std::setw(11) << c.peak_rss / mb
+            << std::setw(9) << c.allocations
+            << std::endl;
+  out.unsetf(std::ios::floatfield);
+}
+
+void printPredicates(std::ostream &out, size_t num_tests,
+                     const std::vector<PredicateCase> &cases) {
+  out << std::fixed << std::setprecision(2);
+  for (const PredicateCase &c : cases) {
+    out << "predicates: " << std::left << std::setw(7) << c.kernel
+        << std::right << " incircle "
+        << num_tests / c.incircle.percentile(0.5) / 1e6
+        << " Mtests/s, orient " << num_tests / c.orient.percentile(0.5) / 1e6
+        << " Mtests/s" << std::endl;
+  }
+  out.unsetf(std::ios::floatfield);
+}
+
+void printSnapshot(std::ostream &out, const Case &c) {
+  out << std::fixed << std::setprecision(2) << "snapshot: "
+      << c.snapshot_bytes / (1024.0 * 1024.0) << " MB, save "
+      << c.snapshot_save.percentile(0.5) * 1e3 << " ms, open "
+      << c.snapshot_open.percentile(0.5) * 1e3 << " ms" << std::endl;
+  out.unsetf(std::ios::floatfield);
+}
+
+void printStream(std::ostream &out, const Case &c) {
+  const double seconds = c.stream_triangulation.percentile(0.5);
+  out << std::fixed << std::setprecision(2) << "stream: triangulation "
+      << seconds * 1e3 << " ms ("
+      << (seconds > 0 ? c.num_vertices / seconds / 1e6 : 0.0)
+      << " Mvertices/s), mst " << c.stream_mst.percentile(0.5) * 1e3
+      << " ms, peak " << c.stream_peak_vertices << " vertices ("
+      << 100.0 * c.stream_peak_vertices / std::max<size_t>(c.num_vertices, 1)
+      << "%)" << std::endl;
+  out.unsetf(std::ios::floatfield);
+}
+
+void printBatch(std::ostream &out, const BatchCase &b) {
+  double median = b.run.percentile(0.5);
+  out << std::fixed << std::setprecision(2) << "batch: " << b.systems
+      << " systems, " << b.points << " points, " << median * 1e3
+      << " ms, " << b.systems / median << " systems/s, "
+      << b.points / median / 1e6 << " Mpoints/s" << std::endl;
+  out.unsetf(std::ios::floatfield);
+}
+
+void writePhase(std::ostream &out, const char *name, const Samples &s,
+                bool last) {
+  out << "        \"" << name << "\": {\"median\": " << s.percentile(0.5)
+      << ", \"p10\": " << s.percentile(0.1)
+      << ", \"p90\": " << s.percentile(0.9)
+      << ", \"min\": " << s.percentile(0.0)
+      << ", \"max\": " << s.percentile(1.0) << "}" << (last ? "\n" : ",\n");
+}
+
+// keys in fixed order, one case per block: diff friendly
+void writeJson(std::ostream &out, const Options &options,
+               const std::vector<Case> &cases, const BatchCase &batch,
+               const std::vector<PredicateCase> &predicates) {
+  out << std::setprecision(9);
+  out << "{\n"
+      << "  \"reps\": " << options.reps << ",\n"
+      << "  \"threads\": " << options.threads << ",\n"
+      << "  \"reuse\": " << (options.reuse ? "true" : "false") << ",\n"
+      << "  \"layout\": \"" << (options.hilbert ? "hilbert" : "recursion")
+      << "\",\n"
+      << "  \"queries\": " << options.queries << ",\n"
+      << "  \"stream_budget\": " << options.stream_budget << ",\n"
+      << "  \"time_unit\": \"s\",\n";
+  if (batch.systems > 0) {
+    out << "  \"batch\": {\n"
+        << "    \"systems\": " << batch.systems << ",\n"
+        << "    \"points\": " << batch.points << ",\n"
+        << "    \"systems_per_second\": "
+        << batch.systems / batch.run.percentile(0.5) << ",\n";
+    writePhase(out, "run", batch.run, true);
+    out << "  },\n";
+  }
+  if (!predicates.empty()) {
+    out << "  \"predicates\": {\n"
+        << "    \"tests\": " << options.predicates << ",\n"
+        << "    \"kernels\": [\n";
+    for (size_t i = 0; i < predicates.size(); i++) {
+      const PredicateCase &c = predicates[i];
+      out << "      {\n"
+          << "        \"kernel\": \"" << c.kernel << "\",\n";
+      writePhase(out, "incircle", c.incircle, false);
+      writePhase(out, "orient", c.orient, true);
+      out << "      }" << (i + 1 < predicates.size() ? ",\n" : "\n");
+    }
+    out << "    ]\n"
+        << "  },\n";
+  }
+  out << "  \"cases\": [\n";
+  for (size_t i = 0; i < cases.size(); i++) {
+    const Case &c = cases[i];
+    out << "    {\n"
+        << "      \"distribution\": \"" << c.distribution << "\",\n"
+        << "      \"scalar\": \"" << c.scalar << "\",\n"
+        << "      \"split\": \"" << splitName(c.split) << "\",\n"
+        << "      \"size\": " << c.size << ",\n"
+        << "      \"vertices\": " << c.num_vertices << ",\n"
+        << "      \"edges\": " << c.num_edges << ",\n"
+        << "      \"edges_created\": " << c.num_edges + c.num_deleted_edges
+        << ",\n"
+        << "      \"edges_deleted\": " << c.num_deleted_edges << ",\n"
+        << "      \"min_d\": " << c.min_d << ",\n"
+        << "      \"edges_per_second\": " << edgesPerSecond(c) << ",\n"
+        << "      \"edge_bytes\": " << c.edge_bytes << ",\n"
+        << "      \"peak_rss_bytes\": " << c.peak_rss << ",\n"
+        << "      \"allocations\": " << c.allocations << ",\n"
+        << "      \"snapshot_bytes\": " << c.snapshot_bytes << ",\n"
+        << "      \"stream_peak_vertices\": " << c.stream_peak_vertices
+        << ",\n"
+        << "      \"phases\": {\n";
+    // phases not run are omitted
+    const std::pair<const char *, const Samples *> all_phases[] = {
+        {"preprocess", &c.preprocess},   {"sort", &c.sort},
+        {"dedup", &c.dedup},             {"triangulation", &c.triangulation},
+        {"reorder", &c.reorder},         {"mst_kruskal", &c.kruskal},
+        {"mst_boruvka", &c.boruvka},     {"dendrogram", &c.dendrogram},
+        {"query", &c.query},             {"snapshot_save", &c.snapshot_save},
+        {"snapshot_open", &c.snapshot_open},
+        {"stream_triangulation", &c.stream_triangulation},
+        {"stream_mst", &c.stream_mst}};
+    std::vector<std::pair<const char *, const Samples *>> phases;
+    for (const auto &phase : all_phases) {
+      if (!phase.second->values.empty()) {
+        phases.push_back(phase);
+      }
+    }
+    for (size_t p = 0; p < phases.size(); p++) {
+      writePhase(out, phases[p].first, *phases[p].second,
+                 p + 1 == phases.size());
+    }
+    out << "      }";
+#ifdef DELAUNAY_STATS
+    // hot path counters of last repetition
+    out << ",\n      \"stats\": ";
+    c.stats.writeJson(out);
+#endif
+    out << "\n    }" << (i + 1 < cases.size() ? ",\n" : "\n");
+  }
+  out << "  ]\n"
+      << "}\n";
+}
+
+} // namespace
+
+// none is inlined: gcc would see malloc and free paired with operator delete
+// and operator new (-Wmismatched-new-delete)
+__attribute__((noinline)) void *operator new(size_t size) {
+  g_allocations++;
+  void *p = std::malloc(size ? size : 1);
+  if (!p) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+__attribute__((noinline)) void operator delete(void *p) noexcept {
+  std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void *p, size_t) noexcept {
+  std::free(p);
+}
+
+int main(int argc, char *argv[]) {
+  Options options;
+  if (!parseOptions(argc, argv, options)) {
+    usage();
+    return 1;
+  }
+
+  if (options.check) {
+    const size_t failures = runChecks();
+    std::cout << (failures == 0 ? "checks passed" : "checks failed")
+              << std::endl;
+    return failures == 0 ? 0 : 1;
+  }
+
+  // peak rss only grows: run sizes in increasing order so that each value
+  // is (mostly) the one of its case
+  std::sort(options.sizes.begin(), options.sizes.end());
+
+  // json on stdout: table goes to stderr
+  std::ostream &table = (options.json == "-") ? std::cerr : std::cout;
+
+  std::vector<Case> cases;
+  printHeader(table);
+  for (size_t size : options.sizes) {
+    for (const std::string &distribution : options.distributions) {
+      for (const std::string &scalar : options.scalars) {
+        for (SplitStrategy split : options.splits) {
+          if (scalar == "double") {
+            cases.push_back(
+                run<double>(options, distribution, split, size, "double"));
+          } else if (scalar == "int32") {
+            cases.push_back(
+                run<int32_t>(options, distribution, split, size, "int32"));
+          } else {
+            cases.push_back(
+                run<float>(options, distribution, split, size, "float"));
+          }
+          printCase(table, cases.back());
+          if (!cases.back().snapshot_open.values.empty()) {
+            printSnapshot(table, cases.back());
+          }
+          if (!cases.back().stream_triangulation.values.empty()) {
+            printStream(table, cases.back());
+          }
+        }
+      }
+    }
+  }
+
+  BatchCase batch;
+  if (options.batch > 0) {
+    batch = runBatch(options);
+    printBatch(table, batch);
+  }
+
+  std::vector<PredicateCase> predicates;
+  if (options.predicates > 0) {
+    predicates = runPredicates(options);
+    printPredicates(table, options.predicates, predicates);
+  }
+
+  if (options.json == "-") {
+    writeJson(std::cout, options, cases, batch, predicates);
+  } else if (!options.json.empty()) {
+    std::ofstream file(options.json);
+    if (!file) {
+      std::cerr << "cannot write " << options.json << std::endl;
+      return 1;
+    }
+    writeJson(file, options, cases, batch, predicates);
+  }
+
+  if (!options.trace.empty() && !cases.empty()) {
+    std::ofstream file(options.trace);
+    if (!file) {
+      std::cerr << "cannot write " << options.trace << std::endl;
+      return 1;
+    }
+    cases.back().stats.writeChromeTrace(file);
+  }
+  return 0;
+}
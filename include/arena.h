@@ -0,0 +1,210 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+/*!
+ * \brief Chunked arena owning objects in contiguous blocks
+ *
+ * Objects never move once allocated (blocks are never reallocated), so raw
+ * pointers handed out stay valid until clear() or destruction. Released slots
+ * are kept in a free list and recycled by the next allocate().
+ *
+ * An object may be released into another arena than the one that allocated
+ * it (as long as both outlive it): counters are then only meaningful summed
+ * over all arenas involved.
+ *
+ * Blocks are aligned on alignof(T), which plain operator new does not do for
+ * over-aligned types before C++17.
+ */
+template <typename T> class Arena {
+public:
+  explicit Arena(size_t block_size = 4096)
+      : m_block_size(block_size), m_used_in_last(0), m_num_allocated(0),
+        m_num_released(0), m_num_recycled(0), m_num_block_allocs(0),
+        m_peak_bytes(0) {}
+
+  ~Arena() { destroyAll(); }
+
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  /*!
+   * \brief Makes sure that num_objects can be allocated without new blocks
+   * \param num_objects number of objects to come
+   */
+  void reserve(size_t num_objects) {
+    size_t free_slots = m_free.size() + (capacity() - size());
+    if (num_objects <= free_slots) {
+      return;
+    }
+    // one single block sized for the missing objects
+    addBlock(num_objects - free_slots);
+  }
+
+  /*!
+   * \brief Constructs a new object, reusing a released slot if available
+   * \return pointer to the new object
+   */
+  T *allocate() {
+    T *slot;
+    if (!m_free.empty()) {
+      slot = m_free.back();
+      m_free.pop_back();
+      slot->~T();
+      m_num_recycled++;
+    } else {
+      if (m_blocks.empty() || m_used_in_last == m_blocks.back().size) {
+        addBlock(m_block_size);
+      }
+      slot = m_blocks.back().data + m_used_in_last++;
+    }
+    m_num_allocated++;
+    return new (slot) T();
+  }
+
+  /*!
+   * \brief Gives back a slot. The object stays readable until it is recycled
+   * \param object pointer returned by allocate()
+   */
+  void release(T *object) {
+    m_free.push_back(object);
+    m_num_released++;
+  }
+
+  /*!
+   * \brief Destroys all objects and gives blocks back to the system
+   * Statistics other than alive objects are kept.
+   */
+  void clear() { destroyAll(); }
+
+  /*!
+   * \brief Destroys all objects but keeps memory for the next ones
+   * Blocks are coalesced into a single one of the same capacity, so that
+   * refilling the arena up to its previous size allocates nothing.
+   */
+  void reset() {
+    size_t slots = capacity();
+    if (m_blocks.size() > 1) {
+      destroyAll();
+      addBlock(slots);
+    } else {
+      destroyObjects();
+      m_free.clear();
+      m_used_in_last = 0;
+      m_num_allocated = 0;
+      m_num_released = 0;
+    }
+  }
+
+  /*!
+   * \brief Calls f on every object ever constructed (alive or released)
+   */
+  template <typename F> void forEach(F f) const {
+    for (size_t b = 0; b < m_blocks.size(); b++) {
+      size_t used = (b + 1 == m_blocks.size()) ? m_used_in_last
+                                                : m_blocks[b].size;
+      for (size_t i = 0; i < used; i++) {
+        f(m_blocks[b].data[i]);
+      }
+    }
+  }
+
+  // number of constructed slots (alive + released)
+  size_t size() const {
+    size_t s = 0;
+    for (size_t b = 0; b + 1 < m_blocks.size(); b++) {
+      s += m_blocks[b].size;
+    }
+    return s + m_used_in_last;
+  }
+  // number of slots allocated from the system
+  size_t capacity() const {
+    size_t c = 0;
+    for (const auto &b : m_blocks) {
+      c += b.size;
+    }
+    return c;
+  }
+  // number of allocate() calls
+  size_t numAllocated() const { return m_num_allocated; }
+  // number of release() calls
+  size_t numReleased() const { return m_num_released; }
+  // number of objects currently alive
+  size_t numAlive() const { return m_num_allocated - m_num_released; }
+  // number of allocate() served from the free list
+  size_t numRecycled() const { return m_num_recycled; }
+  // number of blocks requested to the system allocator
+  size_t numBlockAllocations() const { return m_num_block_allocs; }
+  // highest number of bytes held in blocks
+  size_t peakBytes() const { return m_peak_bytes; }
+
+private:
+  struct Block {
+    T *data;
+    size_t size;
+    void *memory; // as returned by operator new, data is aligned inside
+  };
+
+  void addBlock(size_t size) {
+    // a partially used last block would be skipped: give its tail to the
+    // free list so that forEach() only walks constructed objects
+    if (!m_blocks.empty()) {
+      Block &last = m_blocks.back();
+      for (; m_used_in_last < last.size; m_used_in_last++) {
+        T *slot = new (last.data + m_used_in_last) T();
+        m_free.push_back(slot);
+      }
+    }
+    Block b;
+    b.memory = ::operator new(size * sizeof(T) + alignof(T) - 1);
+    uintptr_t address = reinterpret_cast<uintptr_t>(b.memory);
+    address = (address + alignof(T) - 1) & ~uintptr_t(alignof(T) - 1);
+    b.data = reinterpret_cast<T *>(address);
+    b.size = size;
+    m_blocks.push_back(b);
+    m_used_in_last = 0;
+    m_num_block_allocs++;
+
+    size_t bytes = capacity() * sizeof(T);
+    if (bytes > m_peak_bytes) {
+      m_peak_bytes = bytes;
+    }
+  }
+
+  void destroyObjects() {
+    for (size_t b = 0; b < m_blocks.size(); b++) {
+      size_t used = (b + 1 == m_blocks.size()) ? m_used_in_last
+                                                : m_blocks[b].size;
+      for (size_t i = 0; i < used; i++) {
+        m_blocks[b].data[i].~T();
+      }
+    }
+  }
+
+  void destroyAll() {
+    destroyObjects();
+    for (const Block &b : m_blocks) {
+      ::operator delete(b.memory);
+    }
+    m_blocks.clear();
+    m_free.clear();
+    m_used_in_last = 0;
+    m_num_allocated = 0;
+    m_num_released = 0;
+  }
+
+private:
+  size_t m_block_size;         // size of blocks added on demand
+  std::vector<Block> m_blocks; // all blocks, only the last one is partial
+  size_t m_used_in_last;       // constructed objects inside last block
+  std::vector<T *> m_free;     // released objects to recycle
+
+  // statistics
+  size_t m_num_allocated;
+  size_t m_num_released;
+  size_t m_num_recycled;
+  size_t m_num_block_allocs;
+  size_t m_peak_bytes;
+};
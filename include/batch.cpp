@@ -0,0 +1,81 @@
+#include "batch.h"
+
+#include <atomic>
+#include <numeric>
+
+BatchTriangulator::BatchTriangulator(int num_threads) {
+  if (num_threads < 1) {
+    num_threads = 1;
+  }
+  if (num_threads > 1) {
+    m_pool.reset(new ThreadPool(num_threads));
+  }
+  for (int w = 0; w < num_threads; w++) {
+    m_workers.emplace_back(new Worker());
+  }
+}
+
+void BatchTriangulator::setMstBackend(MstBackend backend) {
+  for (auto &worker : m_workers) {
+    worker->dc.setMstBackend(backend);
+  }
+}
+
+void BatchTriangulator::computeSystem(Worker &worker, const PointSet &system,
+                                      SystemResult &result) {
+  DivideConquer &dc = worker.dc;
+  dc.computeTriangulation(system.points, system.num_points, m_split);
+  worker.solution.clear();
+  result.min_d = dc.computeMinD(worker.solution);
+
+  // first input point of each vertex
+  const std::vector<int> &input_to_vertex = dc.inputToVertex();
+  result.num_vertices = dc.orderedPoints().size();
+  worker.vertex_to_input.assign(result.num_vertices, -1);
+  for (size_t i = 0; i < input_to_vertex.size(); i++) {
+    int &first = worker.vertex_to_input[input_to_vertex[i]];
+    if (first < 0) {
+      first = static_cast<int>(i);
+    }
+  }
+
+  result.tree.clear();
+  result.tree.reserve(worker.solution.size());
+  for (Edge *e : worker.solution) {
+    result.tree.push_back(
+        WeightedEdge{worker.vertex_to_input[e->Org()],
+                     worker.vertex_to_input[e->Dest()],
+                     e->getQuadEdge()->lenght()});
+  }
+}
+
+void BatchTriangulator::run(const std::vector<PointSet> &systems,
+                            std::vector<SystemResult> &results) {
+  results.resize(systems.size());
+  m_order.resize(systems.size());
+  std::iota(m_order.begin(), m_order.end(), 0);
+  std::stable_sort(m_order.begin(), m_order.end(),
+                   [&systems](size_t a, size_t b) {
+                     return systems[a].num_points > systems[b].num_points;
+                   });
+
+  std::atomic<size_t> cursor(0);
+  // one task per worker, each one taking the next largest system left
+  auto drain = [this, &systems, &results, &cursor]() {
+    Worker &worker = *m_workers[m_pool ? m_pool->currentWorker() : 0];
+    for (size_t i = cursor++; i < m_order.size(); i = cursor++) {
+      size_t s = m_order[i];
+      computeSystem(worker, systems[s], results[s]);
+    }
+  };
+  if (!m_pool) {
+    drain();
+    return;
+  }
+  ThreadPool::TaskGroup group(*m_pool);
+  for (int w = 1; w < m_pool->numThreads(); w++) {
+    group.run(drain);
+  }
+  drain();
+  group.wait();
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "delaunay.h"
+#include "thread_pool.h"
+
+// points of one independent system, not copied
+struct PointSet {
+  const float2 *points;
+  size_t num_points;
+};
+
+/*!
+ * \brief Spanning tree of one system of a batch
+ * Tree edges join input point indices (the first input point of each unique
+ * vertex), lenghts are squared.
+ */
+struct SystemResult {
+  float min_d = 0;                // euclidean lenght of longest tree edge
+  size_t num_vertices = 0;        // unique points
+  std::vector<WeightedEdge> tree; // by increasing lenght with Kruskal
+};
+
+/*!
+ * \brief Triangulates many independent point sets concurrently
+ *
+ * Each worker of the pool owns a sequential DivideConquer kept between
+ * systems and batches: its edge arenas and buffers are reused, so a worker
+ * stops allocating once it has seen its largest system. Systems are handed
+ * out largest first from a shared cursor (longest processing time first):
+ * the last systems to start are the smallest ones, which balances workers
+ * without knowing costs in advance.
+ */
+class BatchTriangulator {
+public:
+  /*!
+   * \param num_threads total number of threads, including calling one
+   */
+  explicit BatchTriangulator(int num_threads);
+
+  // algorithm computing spanning trees (Kruskal by default)
+  void setMstBackend(MstBackend backend);
+  // how systems are split (vertical by default)
+  void setSplitStrategy(SplitStrategy split) { m_split = split; }
+
+  /*!
+   * \brief Computes triangulation and spanning tree of every system
+   * \param systems point sets
+   * \param results output, one per system in the same order
+   */
+  void run(const std::vector<PointSet> &systems,
+           std::vector<SystemResult> &results);
+
+private:
+  // per worker state, reused from system to system
+  struct Worker {
+    DivideConquer dc;
+    std::vector<Edge *> solution;
+    std::vector<int> vertex_to_input;
+  };
+
+  void computeSystem(Worker &worker, const PointSet &system,
+                     SystemResult &result);
+
+private:
+  std::unique_ptr<ThreadPool> m_pool; // null when sequential
+  std::vector<std::unique_ptr<Worker>> m_workers;
+  std::vector<size_t> m_order; // systems by decreasing size
+  SplitStrategy m_split = SplitStrategy::Vertical;
+};
@@ -0,0 +1,214 @@
+#include "boruvka.h"
+#include "delaunay.h"
+
+#include <cstring>
+
+namespace {
+
+const uint64_t kNoEdge = ~uint64_t(0);
+const size_t kNoSlot = ~size_t(0);
+
+// lengths are >= 0: their bits compare like the floats
+inline uint64_t pack(float lenght, int vertex) {
+  uint32_t bits;
+  std::memcpy(&bits, &lenght, sizeof(bits));
+  return (uint64_t(bits) << 32) | uint32_t(vertex);
+}
+
+inline void atomicMin(std::atomic<uint64_t> &target, uint64_t value) {
+  uint64_t current = target.load(std::memory_order_relaxed);
+  while (value < current &&
+         !target.compare_exchange_weak(current, value,
+                                       std::memory_order_relaxed)) {
+  }
+}
+
+// vertices per task of a round
+const size_t kRoundGrain = 4096;
+
+} // namespace
+
+template <typename T>
+int BasicBoruvka<T>::findSet(int i) {
+  while (true) {
+    int p = m_parent[i].load(std::memory_order_relaxed);
+    if (p == i) {
+      return i;
+    }
+    int gp = m_parent[p].load(std::memory_order_relaxed);
+    // path halving: a concurrent failure only costs a longer path
+    m_parent[i].compare_exchange_weak(p, gp, std::memory_order_relaxed);
+    i = gp;
+  }
+}
+
+template <typename T>
+bool BasicBoruvka<T>::unionSets(int a, int b) {
+  while (true) {
+    a = findSet(a);
+    b = findSet(b);
+    if (a == b) {
+      return false;
+    }
+    // always link higher root under lower one: no cycle between threads
+    if (a < b) {
+      std::swap(a, b);
+    }
+    int expected = a;
+    if (m_parent[a].compare_exchange_strong(expected, b)) {
+      return true;
+    }
+  }
+}
+
+template <typename T>
+void BasicBoruvka<T>::buildAdjacency(const std::vector<Edge *> &vertex_edge,
+                                     ThreadPool *pool) {
+  const size_t n = vertex_edge.size();
+  m_offset.resize(n + 1);
+  m_degree.resize(n);
+
+  // ring sizes, then offsets
+  ThreadPool::forRange(
+      pool, n, kRoundGrain, [this, &vertex_edge](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; v++) {
+          int degree = 0;
+          Edge *first = vertex_edge[v];
+          if (first) {
+            Edge *e = first;
+            do {
+              degree++;
+              e = e->Onext();
+            } while (e != first);
+          }
+          m_degree[v] = degree;
+        }
+      });
+  m_offset[0] = 0;
+  for (size_t v = 0; v < n; v++) {
+    m_offset[v + 1] = m_offset[v] + m_degree[v];
+  }
+
+  // walk rings again, storing neighbours contiguously
+  const size_t num_slots = m_offset[n];
+  m_neighbour.resize(num_slots);
+  m_lenght.resize(num_slots);
+  m_edge.resize(num_slots);
+  ThreadPool::forRange(
+      pool, n, kRoundGrain, [this, &vertex_edge](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; v++) {
+          Edge *first = vertex_edge[v];
+          if (!first) {
+            continue;
+          }
+          size_t slot = m_offset[v];
+          Edge *e = first;
+          do {
+            m_neighbour[slot] = e->Dest();
+            m_lenght[slot] = e->getQuadEdge()->lenght();
+            m_edge[slot] = e;
+            slot++;
+            e = e->Onext();
+          } while (e != first);
+        }
+      });
+}
+
+template <typename T>
+float BasicBoruvka<T>::computeSolution(
+    const std::vector<Edge *> &vertex_edge, ThreadPool *pool,
+    std::vector<Edge *> &solution) {
+  const size_t n = vertex_edge.size();
+  if (n > m_capacity) {
+    m_parent.reset(new std::atomic<int>[n]);
+    m_component_best.reset(new std::atomic<uint64_t>[n]);
+    m_capacity = n;
+  }
+  buildAdjacency(vertex_edge, pool);
+  m_component.resize(n);
+  m_vertex_best.assign(n, nullptr);
+  m_selected.assign(n, nullptr);
+  for (size_t i = 0; i < n; i++) {
+    m_parent[i] = static_cast<int>(i);
+    m_component_best[i] = kNoEdge;
+  }
+
+  float max_lenght = 0;
+  bool merged = true;
+  while (merged) {
+
+    // 1. flatten sets: neighbours then read one entry each
+    ThreadPool::forRange(
+        pool, n, kRoundGrain, [this](size_t begin, size_t end) {
+          for (size_t v = begin; v < end; v++) {
+            m_component[v] = findSet(static_cast<int>(v));
+          }
+        });
+
+    // 2. each vertex proposes its shortest edge leaving its component.
+    // Components only grow: neighbours inside it are dropped for good.
+    ThreadPool::forRange(
+        pool, n, kRoundGrain, [this](size_t begin, size_t end) {
+          for (size_t v = begin; v < end; v++) {
+            const int root = m_component[v];
+            const size_t first = m_offset[v];
+            size_t last = first + m_degree[v];
+            size_t best = kNoSlot;
+            for (size_t i = first; i < last;) {
+              if (m_component[m_neighbour[i]] == root) {
+                last--;
+                m_neighbour[i] = m_neighbour[last];
+                m_lenght[i] = m_lenght[last];
+                m_edge[i] = m_edge[last];
+                continue;
+              }
+              if (best == kNoSlot || m_lenght[i] < m_lenght[best]) {
+                best = i;
+              }
+              i++;
+            }
+            m_degree[v] = static_cast<int>(last - first);
+
+            if (best != kNoSlot) {
+              m_vertex_best[v] = m_edge[best];
+              atomicMin(m_component_best[root],
+                        pack(m_lenght[best], static_cast<int>(v)));
+            }
+          }
+        });
+
+    // 3. contract every component with its shortest edge
+    ThreadPool::forRange(
+        pool, n, kRoundGrain, [this](size_t begin, size_t end) {
+          for (size_t c = begin; c < end; c++) {
+            uint64_t best = m_component_best[c].load(std::memory_order_relaxed);
+            if (best == kNoEdge) {
+              continue;
+            }
+            Edge *e = m_vertex_best[uint32_t(best)];
+            if (unionSets(e->Org(), e->Dest())) {
+              m_selected[c] = e;
+            }
+          }
+        });
+
+    // 4. collect merged edges and prepare next round
+    merged = false;
+    for (size_t c = 0; c < n; c++) {
+      if (m_selected[c]) {
+        Edge *e = m_selected[c];
+        solution.push_back(e);
+        max_lenght = std::max(max_lenght, e->getQuadEdge()->lenght());
+        m_selected[c] = nullptr;
+        merged = true;
+      }
+      m_component_best[c].store(kNoEdge, std::memory_order_relaxed);
+    }
+  }
+
+  return max_lenght;
+}
+
+template class BasicBoruvka<float>;
+template class BasicBoruvka<double>;
+template class BasicBoruvka<int32_t>;
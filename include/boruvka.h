@@ -0,0 +1,62 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "thread_pool.h"
+
+template <typename T> class BasicEdge;
+
+/*!
+ * \brief Parallel Boruvka minimum spanning tree over a quad-edge graph
+ *
+ * Onext() rings of all vertices are walked once in parallel into flat
+ * neighbour arrays. Each round, every vertex then finds its shortest edge
+ * leaving its component, components keep the shortest of their vertices'
+ * candidates and are contracted with a lock-free union-find. Rounds stop
+ * when no component can be merged anymore.
+ */
+template <typename T> class BasicBoruvka {
+public:
+  typedef BasicEdge<T> Edge;
+
+  /*!
+   * \brief Computes spanning tree of the graph
+   * \param vertex_edge one alive edge out of each vertex (null if isolated)
+   * \param pool optional pool to run rounds in parallel (may be null)
+   * \param solution output edges of the tree
+   * \return maximum squared lenght of the tree edges
+   */
+  float computeSolution(const std::vector<Edge *> &vertex_edge,
+                        ThreadPool *pool, std::vector<Edge *> &solution);
+
+private:
+  // walks rings of all vertices into m_offset.. m_edge
+  void buildAdjacency(const std::vector<Edge *> &vertex_edge,
+                      ThreadPool *pool);
+  // root of vertex set, halving path on the way
+  int findSet(int i);
+  // merges sets of a and b, returns false if already merged
+  bool unionSets(int a, int b);
+
+private:
+  size_t m_capacity = 0;
+  std::unique_ptr<std::atomic<int>[]> m_parent;
+  // per component: (lenght bits << 32 | vertex) of its shortest edge out
+  std::unique_ptr<std::atomic<uint64_t>[]> m_component_best;
+  // neighbours of vertex v: slots [m_offset[v], m_offset[v] + m_degree[v])
+  std::vector<size_t> m_offset;
+  std::vector<int> m_degree; // shrinks as neighbours join the component
+  std::vector<int> m_neighbour;
+  std::vector<float> m_lenght;
+  std::vector<Edge *> m_edge;
+  // per vertex: root of its set at the start of the round
+  std::vector<int> m_component;
+  // per vertex: its shortest edge leaving its component
+  std::vector<Edge *> m_vertex_best;
+  // per vertex: set when its best edge was merged this round
+  std::vector<Edge *> m_selected;
+};
+
+typedef BasicBoruvka<float> Boruvka;
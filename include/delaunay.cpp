@@ -1,13 +1,276 @@
 #include "delaunay.h"
+#include "predicates.h"
+
+#include <chrono>
+
+namespace {
+
+inline double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+// vertices per task when exporting the mesh
+const size_t kExportGrain = 4096;
+
+// lexicographic order in the frame of a cut. Axis 0 sorts x then y: halves
+// are separated by a vertical line. Axis 1 is the frame rotated by -90
+// degrees, sorting y then -x: halves are separated by a horizontal line.
+// Rotations keep orientations, so predicates and merges work unchanged.
+template <typename T>
+inline bool frameLess(const Vec2<T> &a, const Vec2<T> &b, int axis) {
+  if (axis == 0) {
+    return a.x < b.x || (a.x == b.x && a.y < b.y);
+  }
+  return a.y < b.y || (a.y == b.y && a.x > b.x);
+}
+
+// signs of the predicates: float and double coordinates go through the
+// filtered double predicates, int32 ones through exact integer arithmetic
+template <typename T>
+inline int orientSign(const Vec2<T> &a, const Vec2<T> &b, const Vec2<T> &c) {
+  double det = orient2d(a.x, a.y, b.x, b.y, c.x, c.y);
+  return (det > 0) - (det < 0);
+}
+inline int orientSign(const int2 &a, const int2 &b, const int2 &c) {
+  return orient2dInt(a.x, a.y, b.x, b.y, c.x, c.y);
+}
+
+// > 0 when d is inside the circle of ccw (a, b, c)
+template <typename T>
+inline int incircleSign(const Vec2<T> &a, const Vec2<T> &b, const Vec2<T> &c,
+                        const Vec2<T> &d) {
+  double det = incircle(a.x, a.y, b.x, b.y, c.x, c.y, d.x, d.y);
+  return (det > 0) - (det < 0);
+}
+inline int incircleSign(const int2 &a, const int2 &b, const int2 &c,
+                        const int2 &d) {
+  return incircleInt(a.x, a.y, b.x, b.y, c.x, c.y, d.x, d.y);
+}
+
+template <typename T>
+inline double distanceSquared(const Vec2<T> &a, const Vec2<T> &b) {
+  double dx = double(a.x) - double(b.x);
+  double dy = double(a.y) - double(b.y);
+  return dx * dx + dy * dy;
+}
+
+// duplicate rule of PointPreprocessor: equal coordinates, not nearly equal
+// ones (-0 and +0 being equal)
+template <typename T>
+inline bool samePosition(const Vec2<T> &a, const Vec2<T> &b) {
+  return a.x == b.x && a.y == b.y;
+}
+
+// moves hull edges of a triangulation to the first and last vertices in the
+// frame of axis: first is (in/out) a ccw hull edge, out of the first vertex,
+// last a cw hull edge out of the last vertex
+template <typename T>
+void frameExtremes(const Vec2<T> *points, BasicEdge<T> *&first,
+                   BasicEdge<T> *&last, int axis) {
+  // walk the hull ccw: each edge leaves the destination of the previous one
+  BasicEdge<T> *min_out = first;
+  BasicEdge<T> *max_in = first;
+  BasicEdge<T> *e = first;
+  do {
+    if (frameLess(points[e->Org()], points[min_out->Org()], axis)) {
+      min_out = e;
+    }
+    if (frameLess(points[max_in->Dest()], points[e->Dest()], axis)) {
+      max_in = e;
+    }
+    e = e->Rprev();
+  } while (e != first);
+  first = min_out;
+  last = max_in->Sym();
+}
+
+#ifdef DELAUNAY_STATS
+// merges deeper than this are counted but not traced (2^depth merges)
+const int kTraceMaxDepth = 8;
+
+// predicate calls of this thread, read by DivideConquer::recordStats
+thread_local uint64_t t_incircle_calls = 0;
+thread_local uint64_t t_ccw_calls = 0;
+
+#define STATS(...) __VA_ARGS__
+#else
+#define STATS(...)
+#endif
+
+} // namespace
 
 /************ Data Structure *************/
-QuadEdge::QuadEdge() : lenght(0.0), alive(true) {
+template <typename T>
+BasicDivideConquer<T>::BasicDivideConquer() {
+  m_quad_edges.emplace_back(new Arena<QuadEdge>());
+  STATS(resetStats();)
+}
+
+template <typename T>
+void BasicDivideConquer<T>::setNumThreads(int num_threads,
+                                          int parallel_cutoff) {
+  if (num_threads < 1) {
+    num_threads = 1;
+  }
+  m_parallel_cutoff = parallel_cutoff;
+  m_pool.reset(num_threads > 1 ? new ThreadPool(num_threads) : nullptr);
+  while (static_cast<int>(m_quad_edges.size()) < num_threads) {
+    m_quad_edges.emplace_back(new Arena<QuadEdge>());
+  }
+  STATS(resetStats();)
+}
+
+template <typename T>
+void BasicDivideConquer<T>::reset() {
+  m_revision++;
+  for (auto &arena : m_quad_edges) {
+    arena->reset();
+  }
+  m_hull_edge = nullptr;
+  m_ordered_points.clear();
+  m_input_to_vertex.clear();
+  m_split_nodes.clear();
+  m_kruskal_edges.clear();
+  m_kruskal_edge_ptrs.clear();
+  m_vertex_edge.clear();
+  m_star_edge.clear();
+  m_flip_stack.clear();
+  m_move_stamp.clear();
+  m_removed.clear();
+  m_walk_hint = -1;
+  m_phase_times = PhaseTimes();
+  STATS(resetStats();)
+}
+
+template <typename T>
+size_t BasicDivideConquer<T>::numDeletedEdges() const {
+  size_t deleted = 0;
+  for (const auto &arena : m_quad_edges) {
+    deleted += arena->numReleased();
+  }
+  return deleted;
+}
+
+template <typename T>
+size_t BasicDivideConquer<T>::numEdges() const {
+  size_t alive = 0;
+  for (const auto &arena : m_quad_edges) {
+    alive += arena->numAlive();
+  }
+  return alive;
+}
+
+template <typename T>
+size_t BasicDivideConquer<T>::edgeBytes() const {
+  size_t bytes = 0;
+  for (const auto &arena : m_quad_edges) {
+    bytes += arena->peakBytes();
+  }
+  return bytes;
+}
+
+template <typename T>
+TriangulationStats BasicDivideConquer<T>::stats() const {
+  TriangulationStats stats;
+  stats.phase_times = m_phase_times;
+#ifdef DELAUNAY_STATS
+  for (const auto &worker : m_depth_stats) {
+    if (stats.depths.size() < worker.size()) {
+      stats.depths.resize(worker.size());
+    }
+    for (size_t d = 0; d < worker.size(); d++) {
+      stats.depths[d] += worker[d];
+    }
+  }
+  for (const auto &worker : m_trace_events) {
+    stats.events.insert(stats.events.end(), worker.begin(), worker.end());
+  }
+  std::sort(stats.events.begin(), stats.events.end(),
+            [](const TraceEvent &a, const TraceEvent &b) {
+              return a.begin < b.begin;
+            });
+  stats.predicates = m_predicates;
+#endif
+  return stats;
+}
+
+#ifdef DELAUNAY_STATS
+template <typename T>
+void BasicDivideConquer<T>::resetStats() {
+  m_depth_stats.assign(m_quad_edges.size(), std::vector<DepthStats>());
+  m_trace_events.assign(m_quad_edges.size(), std::vector<TraceEvent>());
+  m_stats_start = std::chrono::steady_clock::now();
+  m_predicates_start = predicateCounters();
+  m_predicates = PredicateCounters();
+}
+
+template <typename T>
+typename BasicDivideConquer<T>::StatsMark
+BasicDivideConquer<T>::markStats() {
+  const Arena<QuadEdge> &arena = localArena();
+  StatsMark mark;
+  mark.incircle_calls = t_incircle_calls;
+  mark.ccw_calls = t_ccw_calls;
+  mark.allocated = arena.numAllocated();
+  mark.released = arena.numReleased();
+  mark.begin = std::chrono::steady_clock::now();
+  return mark;
+}
 
-  // Set index
-  e[0].index = 0; // Normal edge
-  e[1].index = 1; // Face edge
-  e[2].index = 2; // Normal edge
-  e[3].index = 3; // Face edge
+template <typename T>
+DepthStats &BasicDivideConquer<T>::recordStats(const StatsMark &mark,
+                                               int depth, const char *name) {
+  const int worker = m_pool ? m_pool->currentWorker() : 0;
+  std::vector<DepthStats> &depths = m_depth_stats[worker];
+  if (static_cast<int>(depths.size()) <= depth) {
+    depths.resize(depth + 1);
+  }
+  // the section ran on this thread only: deltas are its own work
+  const Arena<QuadEdge> &arena = localArena();
+  DepthStats &stats = depths[depth];
+  stats.incircle_calls += t_incircle_calls - mark.incircle_calls;
+  stats.ccw_calls += t_ccw_calls - mark.ccw_calls;
+  stats.edges_created += arena.numAllocated() - mark.allocated;
+  stats.edges_disconnected += arena.numReleased() - mark.released;
+
+  if (name && depth < kTraceMaxDepth) {
+    TraceEvent event;
+    event.name = name;
+    event.thread = worker;
+    event.depth = depth;
+    event.begin =
+        std::chrono::duration<double>(mark.begin - m_stats_start).count();
+    event.duration = secondsSince(mark.begin);
+    m_trace_events[worker].push_back(event);
+  }
+  return stats;
+}
+
+template <typename T>
+void BasicDivideConquer<T>::tracePhase(const char *name, double begin,
+                                       double duration) {
+  const int worker = m_pool ? m_pool->currentWorker() : 0;
+  TraceEvent event;
+  event.name = name;
+  event.thread = worker;
+  event.depth = -1;
+  event.begin = begin;
+  event.duration = duration;
+  m_trace_events[worker].push_back(event);
+}
+#endif
+
+template <typename T> BasicQuadEdge<T>::BasicQuadEdge() {
+  static_assert(sizeof(BasicQuadEdge) == 64 && sizeof(BasicEdge<T>) == 16,
+                "edge rotation is computed from address bits");
+
+  // Vertices of normal edges, data on face edges
+  e[0].vertex = 0;
+  e[2].vertex = 0;
+  setLenght(0.0f);
+  setAlive(true);
 
   // Normal edge pointing to themself
   e[0].next = &(e[0]);
@@ -18,118 +281,214 @@ QuadEdge::QuadEdge() : lenght(0.0), alive(true) {
   e[3].next = &(e[1]);
 }
 
-void Edge::setEndPoints(const Node &ori, const Node &dest) {
-  node = ori;
-  Sym()->node = dest;
-
-  // set lenght when setting edge origin/destination
-  getQuadEdge()->lenght = lenghtSquared(ori.pos, dest.pos);
-}
-
 /*********************** Basic Topological Operators ************************/
 
-bool insideCircle(const float2 &p, const float2 &a, const float2 &b,
-                  const float2 &c) {
-
-  if ((a == p) || (b == p) || (c == p)) {
+template <typename T>
+bool insideCircle(const Vec2<T> &p, const Vec2<T> &a, const Vec2<T> &b,
+                  const Vec2<T> &c) {
+  STATS(t_incircle_calls++;)
+  // a point equal to a, b or c is on the circle: skip the exact path that
+  // the filter would take for this zero determinant
+  if ((a.x == p.x && a.y == p.y) || (b.x == p.x && b.y == p.y) ||
+      (c.x == p.x && c.y == p.y)) {
     return false;
   }
+  return incircleSign(a, b, c, p) > 0;
+}
 
-  return (a.x * a.x + a.y * a.y) * computeArea(b, c, p) -
-             (b.x * b.x + b.y * b.y) * computeArea(a, c, p) +
-             (c.x * c.x + c.y * c.y) * computeArea(a, b, p) -
-             (p.x * p.x + p.y * p.y) * computeArea(a, b, c) >
-         0.0;
+template <typename T>
+bool ccw(const Vec2<T> &a, const Vec2<T> &b, const Vec2<T> &c) {
+  STATS(t_ccw_calls++;)
+  return orientSign(a, b, c) > 0;
 }
 
-bool ccw(const float2 &a, const float2 &b, const float2 &c) {
-  return (computeArea(a, b, c) > 0.0);
+template <typename T>
+bool rightOf(const Vec2<T> *points, const Vec2<T> &p, const BasicEdge<T> *e) {
+  return ccw(p, points[e->Dest()], points[e->Org()]);
 }
 
-bool rightOf(const float2 &p, Edge *e) {
-  return ccw(p, e->Dest2d(), e->Org2d());
+template <typename T>
+bool leftOf(const Vec2<T> *points, const Vec2<T> &p, const BasicEdge<T> *e) {
+  return ccw(p, points[e->Org()], points[e->Dest()]);
 }
 
-bool leftOf(const float2 &p, Edge *e) {
-  return ccw(p, e->Org2d(), e->Dest2d());
+template <typename T>
+bool isValid(const Vec2<T> *points, const BasicEdge<T> *e,
+             const BasicEdge<T> *basel) {
+  return rightOf(points, points[e->Dest()], basel);
 }
 
-bool isValid(Edge *e, Edge *basel) { return rightOf(e->Dest2d(), basel); }
+template <typename T>
+Arena<typename BasicDivideConquer<T>::QuadEdge> &
+BasicDivideConquer<T>::localArena() {
+  // each worker allocates in its own arena: no contention on edge creation
+  return *m_quad_edges[m_pool ? m_pool->currentWorker() : 0];
+}
 
-Edge *DivideConquer::makeEdge() {
-  std::shared_ptr<QuadEdge> ql =
-      std::make_shared<QuadEdge>(); // create 4 definition of edge
-  m_quad_edges.push_back(ql);
+template <typename T>
+typename BasicDivideConquer<T>::Edge *BasicDivideConquer<T>::makeEdge() {
+  QuadEdge *ql = localArena().allocate(); // create 4 definition of edge
   return ql->e;
 }
 
-Edge *DivideConquer::makeEdgeFrom(const Node &ori, const Node &de) {
+template <typename T>
+typename BasicDivideConquer<T>::Edge *
+BasicDivideConquer<T>::makeEdgeFrom(const Node &ori, const Node &de) {
   Edge *e = makeEdge();
-  e->setEndPoints(ori, de);
+  e->setEndPoints(ori.id, de.id);
+  e->getQuadEdge()->setLenght(lenghtSquared(ori.pos, de.pos));
   return e;
 }
 
-void Splice(Edge *a, Edge *b) {
-  Edge *alpha = a->Onext()->Rot();
-  Edge *beta = b->Onext()->Rot();
+template <typename T> void Splice(BasicEdge<T> *a, BasicEdge<T> *b) {
+  BasicEdge<T> *alpha = a->Onext()->Rot();
+  BasicEdge<T> *beta = b->Onext()->Rot();
 
-  Edge *t1 = b->Onext();
-  Edge *t2 = a->Onext();
-  Edge *t3 = beta->Onext();
-  Edge *t4 = alpha->Onext();
+  BasicEdge<T> *t1 = b->Onext();
+  BasicEdge<T> *t2 = a->Onext();
+  BasicEdge<T> *t3 = beta->Onext();
+  BasicEdge<T> *t4 = alpha->Onext();
   a->next = t1;
   b->next = t2;
   alpha->next = t3;
   beta->next = t4;
 }
-void DivideConquer::disconnectEdge(Edge *e) {
+template <typename T>
+void BasicDivideConquer<T>::disconnectEdge(Edge *e) {
   Splice(e, e->Oprev());
   Splice(e->Sym(), e->Sym()->Oprev());
 
-  // set alive false to no consider it nor remove it
-  e->getQuadEdge()->alive = false;
-  m_num_deleted_edges++;
-  // delete e->Qedge();
+  // set alive false to no consider it, its slot is recycled by makeEdge
+  e->getQuadEdge()->setAlive(false);
+  localArena().release(e->getQuadEdge());
 }
 
-Edge *DivideConquer::connect(Edge *a, Edge *b) {
+template <typename T>
+typename BasicDivideConquer<T>::Edge *
+BasicDivideConquer<T>::connect(Edge *a, Edge *b) {
   Edge *e = makeEdge();
   e->setEndPoints(a->Dest(), b->Org());
+  e->getQuadEdge()->setLenght(
+      lenghtSquared(m_ordered_points[a->Dest()], m_ordered_points[b->Org()]));
 
   Splice(e, a->Lnext());
   Splice(e->Sym(), b);
-  e->getQuadEdge()->lenght = lenghtSquared(a->Dest().pos, b->Org().pos);
 
   return e;
 }
 
 /************************* Delaunay Triangulation Algorithm  ******************/
 
-void DivideConquer::recursiveDelaunay(Edge *&o_left, Edge *&o_right,
-                                      int left_idx, int right_idx) {
-  // starts calling
-  // delaunay(o_left, o_right, 0, point_size-1)
-  //
-  auto numb_points = 1 + right_idx - left_idx;
-  if (numb_points == 2) {
+template <typename T>
+void BasicDivideConquer<T>::mergeHalves(Edge *&ldo, Edge *ldi, Edge *rdi,
+                                        Edge *&rdo, int depth) {
+  STATS(StatsMark mark = markStats(); uint64_t tangent_iterations = 0;
+        uint64_t merge_iterations = 0;)
+  const Point *points = m_ordered_points.data();
+
+  // Compute the lower common tangent of Left side and Right
+  do {
+    if (leftOf(points, points[rdi->Org()], ldi)) {
+      ldi = ldi->Lnext();
+      STATS(tangent_iterations++;)
+    } else if (rightOf(points, points[ldi->Org()], rdi)) {
+      rdi = rdi->Rprev();
+      STATS(tangent_iterations++;)
+    } else {
+      break;
+    }
+  } while (true);
+
+  // Create a first cross edge base1 from rdi.Org to ldi.Org
+  Edge *basel = connect(rdi->Sym(), ldi);
+  if (ldi->Org() == ldo->Org()) {
+    ldo = basel->Sym();
+  }
+  if (rdi->Org() == rdo->Org()) {
+    rdo = basel;
+  }
+
+  // This is the merge loop.
+  do {
+    // Locate the first L point (lcand.Dest) to be encountered by the rising
+    // bubble, and delete L edges out of basel.Dest that fail the circle test.
+    Edge *lcand = basel->Sym()->Onext();
+    if (isValid(points, lcand, basel)) {
+      while (insideCircle(points[lcand->Onext()->Dest()],
+                          points[basel->Dest()], points[basel->Org()],
+                          points[lcand->Dest()])) {
+        Edge *t = lcand->Onext();
+        disconnectEdge(lcand);
+        lcand = t;
+      }
+    }
+
+    // Symmetrically, locate the first R point to be hit, and delete R edges
+    Edge *rcand = basel->Oprev();
+    if (isValid(points, rcand, basel)) {
+      while (insideCircle(points[rcand->Oprev()->Dest()],
+                          points[basel->Dest()], points[basel->Org()],
+                          points[rcand->Dest()])) {
+        Edge *t = rcand->Oprev();
+        disconnectEdge(rcand);
+        rcand = t;
+      }
+    }
+
+    // If both lcand and rcand are invalid, then basel is the upper common
+    // tangent
+    if (!isValid(points, lcand, basel) && !isValid(points, rcand, basel))
+      break;
+
+    // The next cross edge is to be connected to either lcand.Dest or
+    // rcand.Dest If both are valid, then choose the appropriate one using the
+    // InCircle test
+    if (!isValid(points, lcand, basel) ||
+        (isValid(points, rcand, basel) &&
+         insideCircle(points[rcand->Dest()], points[lcand->Dest()],
+                      points[lcand->Org()], points[rcand->Org()]))) {
+      // Add cross edge basel from rcand.Dest to basel.Dest
+      basel = connect(rcand, basel->Sym());
+    } else {
+      // Add cross edge base1 from basel->Org() to lcand.Dest
+      basel = connect(basel->Sym(), lcand->Sym());
+    }
+    STATS(merge_iterations++;)
+
+  } while (true);
+
+#ifdef DELAUNAY_STATS
+  DepthStats &stats = recordStats(mark, depth, "merge");
+  stats.merges++;
+  stats.tangent_iterations += tangent_iterations;
+  stats.merge_iterations += merge_iterations;
+#else
+  (void)depth; // statistics only
+#endif
+}
+
+template <typename T>
+void BasicDivideConquer<T>::baseDelaunay(Edge *&o_left, Edge *&o_right,
+                                         const Node *nodes, int num_nodes,
+                                         int depth) {
+  STATS(StatsMark mark = markStats();)
+  if (num_nodes == 2) {
     // a,b be the two sites, in sorted order.
-    Node a(m_ordered_points[left_idx], m_num_nodes++);
-    Node b(m_ordered_points[right_idx], m_num_nodes++);
+    const Node &a = nodes[0];
+    const Node &b = nodes[1];
 
     // Create an edge e from a to b
     Edge *e = makeEdgeFrom(a, b);
 
     o_left = e;
     o_right = e->Sym();
-
-    return;
   }
   // abc
-  else if (numb_points == 3) {
+  else {
     // a, b, c be the three sites, in sorted order.
-    Node a(m_ordered_points[left_idx], m_num_nodes++);
-    Node b(m_ordered_points[left_idx + 1], m_num_nodes++);
-    Node c(m_ordered_points[right_idx], m_num_nodes++);
+    const Node &a = nodes[0];
+    const Node &b = nodes[1];
+    const Node &c = nodes[2];
 
     // Create edges ab connecting a-b and bc connecting b-c
     Edge *ab = makeEdgeFrom(a, b);
@@ -138,14 +497,12 @@ void DivideConquer::recursiveDelaunay(Edge *&o_left, Edge *&o_right,
 
     //  Now close triangle
     // c.y < b.y
-    if (ccw(m_ordered_points[left_idx], m_ordered_points[left_idx + 1],
-            m_ordered_points[right_idx])) {
+    if (ccw(a.pos, b.pos, c.pos)) {
       connect(bc, ab);
       o_left = ab;
       o_right = bc->Sym();
 
-    } else if (ccw(m_ordered_points[left_idx], m_ordered_points[right_idx],
-                   m_ordered_points[left_idx + 1])) {
+    } else if (ccw(a.pos, c.pos, b.pos)) {
       Edge *c = connect(bc, ab);
       o_left = c->Sym();
       o_right = c;
@@ -156,89 +513,58 @@ void DivideConquer::recursiveDelaunay(Edge *&o_left, Edge *&o_right,
       o_left = ab;
       o_right = bc->Sym();
     }
+  }
+  STATS(recordStats(mark, depth, nullptr);)
+#ifndef DELAUNAY_STATS
+  (void)depth; // statistics only
+#endif
+}
 
+template <typename T>
+void BasicDivideConquer<T>::recursiveDelaunay(Edge *&o_left, Edge *&o_right,
+                                              int left_idx, int right_idx,
+                                              int depth) {
+  // starts calling
+  // delaunay(o_left, o_right, 0, point_size-1)
+  //
+  auto numb_points = 1 + right_idx - left_idx;
+  if (numb_points <= 3) {
+    const Node nodes[3] = {Node(m_ordered_points[left_idx], left_idx),
+                           Node(m_ordered_points[left_idx + 1], left_idx + 1),
+                           Node(m_ordered_points[right_idx], right_idx)};
+    baseDelaunay(o_left, o_right, nodes, numb_points, depth);
     return;
   }
   // more than 3 points => recursive
   else {
 
     int lenght_half = numb_points / 2;
-    // Compute delaunay onto leght side
     Edge *ldo; // leghtleft
     Edge *ldi; // leftright
-    recursiveDelaunay(ldo, ldi, left_idx, left_idx + lenght_half - 1);
-
-    // Compute delaunay onto right side
     Edge *rdi; // rightleft
     Edge *rdo; // rightright
-    recursiveDelaunay(rdi, rdo, left_idx + lenght_half, right_idx);
-
-    // Compute the lower common tangent of Left side and Right
-    do {
-      if (leftOf(rdi->Org2d(), ldi)) {
-        ldi = ldi->Lnext();
-      } else if (rightOf(ldi->Org2d(), rdi)) {
-        rdi = rdi->Rprev();
-      } else {
-        break;
-      }
-    } while (true);
 
-    // Create a first cross edge base1 from rdi.Org to ldi.Org
-    Edge *basel = connect(rdi->Sym(), ldi);
-    if (ldi->Org2d() == ldo->Org2d()) {
-      ldo = basel->Sym();
-    }
-    if (rdi->Org2d() == rdo->Org2d()) {
-      rdo = basel;
+    if (m_pool && numb_points >= m_parallel_cutoff) {
+      // Both halves touch disjoint points and edges: left one is a task that
+      // any idle worker can steal, right one is done by this thread
+      ThreadPool::TaskGroup halves(*m_pool);
+      halves.run([&] {
+        recursiveDelaunay(ldo, ldi, left_idx, left_idx + lenght_half - 1,
+                          depth + 1);
+      });
+      recursiveDelaunay(rdi, rdo, left_idx + lenght_half, right_idx,
+                        depth + 1);
+      halves.wait();
+    } else {
+      // Compute delaunay onto leght side
+      recursiveDelaunay(ldo, ldi, left_idx, left_idx + lenght_half - 1,
+                        depth + 1);
+      // Compute delaunay onto right side
+      recursiveDelaunay(rdi, rdo, left_idx + lenght_half, right_idx,
+                        depth + 1);
     }
 
-    // This is the merge loop.
-    do {
-      // Locate the first L point (lcand->Dest2d()) to be encountered by the
-      // rising bubble, and delete L edges out of base1->Dest2d() that fail the
-      // circle test.
-      Edge *lcand = basel->Sym()->Onext();
-      if (isValid(lcand, basel)) {
-        while (insideCircle(lcand->Onext()->Dest2d(), basel->Dest2d(),
-                            basel->Org2d(), lcand->Dest2d())) {
-          Edge *t = lcand->Onext();
-          disconnectEdge(lcand);
-          lcand = t;
-        }
-      }
-
-      // Symmetrically, locate the first R point to be hit, and delete R edges
-      Edge *rcand = basel->Oprev();
-      if (isValid(rcand, basel)) {
-        while (insideCircle(rcand->Oprev()->Dest2d(), basel->Dest2d(),
-                            basel->Org2d(), rcand->Dest2d())) {
-          Edge *t = rcand->Oprev();
-          disconnectEdge(rcand);
-          rcand = t;
-        }
-      }
-
-      // If both lcand and rcand are invalid, then basel is the upper common
-      // tangent
-      if (!isValid(lcand, basel) && !isValid(rcand, basel))
-        break;
-
-      // The next cross edge is to be connected to either lcand->Dest2d() or
-      // rcand->Dest2d() If both are valid, then choose the appropriate one
-      // using the InCircle test
-      if (!isValid(lcand, basel) ||
-          (isValid(rcand, basel) &&
-           insideCircle(rcand->Dest2d(), lcand->Dest2d(), lcand->Org2d(),
-                        rcand->Org2d()))) {
-        // Add cross edge basel from rcand->Dest2d() to basel->Dest2d()
-        basel = connect(rcand, basel->Sym());
-      } else {
-        // Add cross edge base1 from basel->Org() to lcand->->Dest2d()
-        basel = connect(basel->Sym(), lcand->Sym());
-      }
-
-    } while (true);
+    mergeHalves(ldo, ldi, rdi, rdo, depth);
 
     o_left = ldo;
     o_right = rdo;
@@ -247,109 +573,990 @@ void DivideConquer::recursiveDelaunay(Edge *&o_left, Edge *&o_right,
   }
 }
 
-void DivideConquer::computeTriangulation(
-    std::vector<float2> const &a_stars_system) {
+template <typename T>
+void BasicDivideConquer<T>::alternatingDelaunay(Edge *&o_left,
+                                                Edge *&o_right, int begin,
+                                                int end, int axis, int depth) {
+  Node *nodes = m_split_nodes.data() + begin;
+  const int num_nodes = end - begin;
+  auto less = [axis](const Node &a, const Node &b) {
+    return frameLess(a.pos, b.pos, axis);
+  };
+  if (num_nodes <= 3) {
+    std::sort(nodes, nodes + num_nodes, less);
+    baseDelaunay(o_left, o_right, nodes, num_nodes, depth);
+    return;
+  }
+
+  // halves separated by a cut along axis, each one cut along the other axis
+  const int half = num_nodes / 2;
+  std::nth_element(nodes, nodes + half, nodes + num_nodes, less);
+  Edge *ldo;
+  Edge *ldi;
+  Edge *rdi;
+  Edge *rdo;
+  if (m_pool && num_nodes >= m_parallel_cutoff) {
+    ThreadPool::TaskGroup halves(*m_pool);
+    halves.run([&] {
+      alternatingDelaunay(ldo, ldi, begin, begin + half, 1 - axis, depth + 1);
+    });
+    alternatingDelaunay(rdi, rdo, begin + half, end, 1 - axis, depth + 1);
+    halves.wait();
+  } else {
+    alternatingDelaunay(ldo, ldi, begin, begin + half, 1 - axis, depth + 1);
+    alternatingDelaunay(rdi, rdo, begin + half, end, 1 - axis, depth + 1);
+  }
 
-  std::vector<float2> temp_stars_system = a_stars_system;
-  // Sort points front left-to-right, then down-up only if X==Y
-  std::sort(temp_stars_system.begin(), temp_stars_system.end(),
-            [](const float2 &a, const float2 &b) {
-              if (std::abs(a.x - b.x) < EPSILON) // same x
-                return (a.y < b.y);              // down to up
-              return a.x < b.x;                  // left to right
-            });
+  // hull edges of the halves are extreme in the frame of their own cut
+  frameExtremes(m_ordered_points.data(), ldo, ldi, axis);
+  frameExtremes(m_ordered_points.data(), rdi, rdo, axis);
+  mergeHalves(ldo, ldi, rdi, rdo, depth);
 
-  m_ordered_points.reserve(temp_stars_system.size());
-  // remove repeated:
-  // worst: all equals? -> O(n), all diff -> O(2*n) = O(n)
-  for (size_t i(0); i < temp_stars_system.size(); i++) {
+  o_left = ldo;
+  o_right = rdo;
+}
 
-    const float2 &p = temp_stars_system[i];
-    m_ordered_points.push_back(p);
+template <typename T>
+void BasicDivideConquer<T>::computeTriangulation(
+    std::vector<Point> const &a_stars_system, SplitStrategy split) {
+  computeTriangulation(a_stars_system.data(), a_stars_system.size(), split);
+}
 
-    for (size_t j(i + 1); j < temp_stars_system.size(); j++) {
-      const float2 &q = temp_stars_system[j];
-      // not same
-      if (fabsf(q.x - p.x) != 0 || fabsf(q.y - p.y) != 0) {
-        break;
-      }
-      // found similar: skip!
-      i++;
-    }
-  }
+template <typename T>
+void BasicDivideConquer<T>::computeTriangulation(const Point *points,
+                                                 size_t num_points,
+                                                 SplitStrategy split) {
+  auto start = std::chrono::steady_clock::now();
+  reset();
+  m_split = split;
+
+  // Sort points left-to-right, then down-up if same x, and remove
+  // duplicates (radix sort on a permutation: input is not copied)
+  m_preprocess.run(points, num_points, m_dedup_policy, m_pool.get(),
+                   m_ordered_points, m_input_to_vertex);
+  m_phase_times.preprocess = secondsSince(start);
+  m_phase_times.sort = m_preprocess.sortSeconds();
+  m_phase_times.dedup = m_preprocess.dedupSeconds();
+  STATS(tracePhase("sort", 0.0, m_phase_times.sort);
+        tracePhase("dedup", m_phase_times.sort, m_phase_times.dedup);)
+  start = std::chrono::steady_clock::now();
 
-  // Reserve the best case:
+  // Reserve the worst case of alive edges:
   // #edges = (3* #triangles+b)/2 = (6*n-3*b-6+b) /2
   // #edges = 3*n-b-3 => most edge = 3*n-3-3
-  m_quad_edges.reserve(3 * m_ordered_points.size() - 6);
+  // Merge loop deletes edges before connecting new ones and deleted slots are
+  // recycled, so alive edges never exceed this bound at any time.
+  // With several threads, arenas share the bound and grow on demand.
+  const size_t num_vertices = m_ordered_points.size();
+  const size_t max_edges = num_vertices < 3 ? 1 : 3 * num_vertices - 6;
+  for (auto &arena : m_quad_edges) {
+    arena->reserve(max_edges / m_quad_edges.size() + 1);
+  }
+  // a single point has no edge
+  if (num_vertices < 2) {
+    return;
+  }
   // Divide and Conquer:
   // https://dl.acm.org/doi/pdf/10.1145/282918.282923
   Edge *oleft;
   Edge *oright;
-  recursiveDelaunay(oleft, oright, 0, m_ordered_points.size() - 1);
+  if (split == SplitStrategy::Alternating) {
+    m_split_nodes.resize(num_vertices);
+    for (size_t v = 0; v < num_vertices; v++) {
+      m_split_nodes[v] = Node(m_ordered_points[v], static_cast<int>(v));
+    }
+    alternatingDelaunay(oleft, oright, 0, static_cast<int>(num_vertices), 0,
+                        0);
+  } else {
+    recursiveDelaunay(oleft, oright, 0, m_ordered_points.size() - 1);
+  }
+  m_hull_edge = oleft;
+  m_phase_times.triangulation = secondsSince(start);
+
+#ifdef DELAUNAY_STATS
+  tracePhase("triangulation", m_phase_times.preprocess,
+             m_phase_times.triangulation);
+  PredicateCounters end = predicateCounters();
+  m_predicates.orient_filtered =
+      end.orient_filtered - m_predicates_start.orient_filtered;
+  m_predicates.orient_exact = end.orient_exact - m_predicates_start.orient_exact;
+  m_predicates.incircle_filtered =
+      end.incircle_filtered - m_predicates_start.incircle_filtered;
+  m_predicates.incircle_exact =
+      end.incircle_exact - m_predicates_start.incircle_exact;
+#endif
   return;
 }
 
-/****************** Kruksal ******************/
+template <typename T>
+void BasicDivideConquer<T>::vertexEdges(
+    std::vector<Edge *> &vertex_edge) const {
+  vertex_edge.assign(m_ordered_points.size(), nullptr);
+  for (const auto &arena : m_quad_edges) {
+    arena->forEach([&vertex_edge](QuadEdge &q) {
+      if (q.alive()) {
+        vertex_edge[q.e[0].Org()] = &q.e[0];
+        vertex_edge[q.e[2].Org()] = &q.e[2];
+      }
+    });
+  }
+}
 
-int findCluster(int idx, const std::vector<int> &a_cluster) {
-  if (idx == a_cluster[idx]) {
-    return idx;
-  } else {
-    return findCluster(a_cluster[idx], a_cluster);
+/****************** Export ******************/
+
+template <typename T>
+void BasicDivideConquer<T>::exportMesh(TriangulationMesh &mesh) {
+  const size_t num_vertices = m_ordered_points.size();
+  ThreadPool *pool = m_pool.get();
+
+  // 1. one sequential pass on arenas: an edge out of each vertex and degrees
+  m_vertex_edge.assign(num_vertices, nullptr);
+  mesh.offsets.assign(num_vertices + 1, 0);
+  for (const auto &arena : m_quad_edges) {
+    arena->forEach([this, &mesh](QuadEdge &q) {
+      if (q.alive()) {
+        m_vertex_edge[q.e[0].Org()] = &q.e[0];
+        m_vertex_edge[q.e[2].Org()] = &q.e[2];
+        mesh.offsets[q.e[0].Org() + 1]++;
+        mesh.offsets[q.e[2].Org() + 1]++;
+      }
+    });
+  }
+  for (size_t v = 0; v < num_vertices; v++) {
+    mesh.offsets[v + 1] += mesh.offsets[v];
+  }
+
+  // 2. single walk of each ring: neighbours in ccw order, and triangles
+  // between consecutive neighbours, flagged on the slot of their first
+  // edge. A triangle is owned by its smallest vertex id.
+  const size_t num_slots = mesh.offsets[num_vertices];
+  mesh.neighbours.resize(num_slots);
+  mesh.lenghts.resize(num_slots);
+  m_triangle_slot.resize(num_slots);
+  m_triangle_offsets.assign(num_vertices + 1, 0);
+  const Point *points = m_ordered_points.data();
+  ThreadPool::forRange(
+      pool, num_vertices, kExportGrain,
+      [this, points, &mesh](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; v++) {
+          Edge *first = m_vertex_edge[v];
+          if (!first) {
+            continue;
+          }
+          const int id = static_cast<int>(v);
+          uint32_t owned = 0;
+          uint32_t k = mesh.offsets[v];
+          Edge *e = first;
+          do {
+            Edge *next = e->Onext();
+            const int dest = e->Dest();
+            mesh.neighbours[k] = dest;
+            mesh.lenghts[k] = e->getQuadEdge()->lenght();
+            m_triangle_slot[k] =
+                dest > id && next->Dest() > id &&
+                ccw(points[id], points[dest], points[next->Dest()]);
+            owned += m_triangle_slot[k];
+            k++;
+            e = next;
+          } while (e != first);
+          m_triangle_offsets[v + 1] = owned;
+        }
+      });
+  for (size_t v = 0; v < num_vertices; v++) {
+    m_triangle_offsets[v + 1] += m_triangle_offsets[v];
+  }
+
+  // 3. triangles from flagged slots, reading the compact adjacency only
+  mesh.triangles.resize(3 * size_t(m_triangle_offsets[num_vertices]));
+  ThreadPool::forRange(
+      pool, num_vertices, kExportGrain,
+      [this, &mesh](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; v++) {
+          size_t t = 3 * size_t(m_triangle_offsets[v]);
+          const uint32_t first = mesh.offsets[v];
+          const uint32_t last = mesh.offsets[v + 1];
+          for (uint32_t k = first; k < last; k++) {
+            if (m_triangle_slot[k]) {
+              mesh.triangles[t++] = static_cast<uint32_t>(v);
+              mesh.triangles[t++] = mesh.neighbours[k];
+              mesh.triangles[t++] =
+                  mesh.neighbours[k + 1 < last ? k + 1 : first];
+            }
+          }
+        }
+      });
+
+  // 4. hull: walk the outer face from the ccw hull edge out of the leftmost
+  // vertex. Collinear points have no inner face, their hull is a segment.
+  mesh.hull.clear();
+  if (!m_hull_edge) {
+    // a single vertex (others removed, if any)
+    for (uint32_t v = 0; v < num_vertices && mesh.hull.empty(); v++) {
+      if (!isRemoved(v)) {
+        mesh.hull.push_back(v);
+      }
+    }
+    return;
+  }
+  if (mesh.triangles.empty()) {
+    // other end of the segment: greatest point, x then y
+    uint32_t last = m_hull_edge->Org();
+    for (uint32_t v = 0; v < num_vertices; v++) {
+      if (isRemoved(v)) {
+        continue;
+      }
+      const Point &p = m_ordered_points[v];
+      const Point &q = m_ordered_points[last];
+      if (p.x > q.x || (p.x == q.x && p.y > q.y)) {
+        last = v;
+      }
+    }
+    mesh.hull.push_back(m_hull_edge->Org());
+    mesh.hull.push_back(last);
+    return;
+  }
+  // updates may have left the hull edge elsewhere
+  Edge *last = nullptr;
+  frameExtremes(m_ordered_points.data(), m_hull_edge, last, 0);
+  Edge *e = m_hull_edge;
+  do {
+    mesh.hull.push_back(e->Org());
+    e = e->Rprev();
+  } while (e != m_hull_edge);
+}
+
+template <typename T>
+void BasicDivideConquer<T>::releaseEdges() {
+  m_revision++;
+  for (auto &arena : m_quad_edges) {
+    arena->clear();
   }
+  m_reorder_arena.reset();
+  m_hull_edge = nullptr;
+  // buffers holding edge pointers
+  std::vector<Edge *>().swap(m_vertex_edge);
+  std::vector<Edge *>().swap(m_star_edge);
+  std::vector<Edge *>().swap(m_kruskal_edge_ptrs);
+  std::vector<WeightedEdge>().swap(m_kruskal_edges);
 }
-float DivideConquer::computeKruskalMinD(std::vector<Edge *> &a_solution) {
-  // init
-  float min_d = 0;
 
-  // generate unique ids for set for each node
-  std::vector<int> cluster_id;
-  cluster_id.resize(m_num_nodes);
-  std::iota(std::begin(cluster_id), std::end(cluster_id), 0);
+/****************** Reorder ******************/
+
+template <typename T>
+void BasicDivideConquer<T>::reorderVertices() {
+  const size_t num_vertices = m_ordered_points.size();
+  if (num_vertices < 2) {
+    return;
+  }
+  m_revision++;
 
-  // get only alive edges (edges are easier to sort)
-  std::vector<Edge *> valid_edges;
-  valid_edges.reserve(m_quad_edges.size() - m_num_deleted_edges);
-  for (const auto &i : m_quad_edges) {
-    if (i->alive) {
-      valid_edges.push_back(i->e);
+  // 1. new id of each vertex: its rank along the curve
+  m_hilbert.computeRanks(m_ordered_points.data(), num_vertices, m_pool.get(),
+                         m_vertex_rank);
+  m_reorder_points.resize(num_vertices);
+  for (size_t v = 0; v < num_vertices; v++) {
+    m_reorder_points[m_vertex_rank[v]] = m_ordered_points[v];
+  }
+  m_ordered_points.swap(m_reorder_points);
+  for (int &v : m_input_to_vertex) {
+    v = m_vertex_rank[v];
+  }
+  if (!m_removed.empty()) {
+    m_kinetic_removed.resize(num_vertices);
+    for (size_t v = 0; v < num_vertices; v++) {
+      m_kinetic_removed[m_vertex_rank[v]] = m_removed[v];
     }
+    m_removed.swap(m_kinetic_removed);
+  }
+  m_move_stamp.clear();
+  m_walk_hint = -1;
+
+  // 2. alive quad edges bucketed by their smallest new end point id: edges
+  // of a vertex are contiguous, and vertices follow the curve
+  m_reorder_offsets.assign(num_vertices + 1, 0);
+  for (const auto &arena : m_quad_edges) {
+    arena->forEach([this](QuadEdge &q) {
+      if (q.alive()) {
+        uint32_t u = m_vertex_rank[q.e[0].Org()];
+        uint32_t v = m_vertex_rank[q.e[2].Org()];
+        m_reorder_offsets[std::min(u, v) + 1]++;
+      }
+    });
+  }
+  for (size_t v = 0; v < num_vertices; v++) {
+    m_reorder_offsets[v + 1] += m_reorder_offsets[v];
   }
 
-  // sort valid edges by lenght
-  std::sort(valid_edges.begin(), valid_edges.end(), [](Edge *i, Edge *j) {
-    return (i->getQuadEdge()->lenght < j->getQuadEdge()->lenght);
+  // 3. scatter copies into the spare arena (one block: slots are
+  // contiguous), reading old arenas sequentially. The first edge of each old
+  // quad edge then forwards to its copy, so that links can be translated.
+  const size_t num_alive = m_reorder_offsets[num_vertices];
+  // sized like arena 0 so that the next triangulation fits as well
+  if (!m_reorder_arena || m_reorder_arena->capacity() < num_alive) {
+    m_reorder_arena.reset(new Arena<QuadEdge>());
+    m_reorder_arena->reserve(std::max(num_alive, m_quad_edges[0]->capacity()));
+  }
+  Arena<QuadEdge> *arena = m_reorder_arena.get();
+  arena->reset();
+  arena->reserve(num_alive);
+  QuadEdge *copies = num_alive ? arena->allocate() : nullptr;
+  for (size_t i = 1; i < num_alive; i++) {
+    arena->allocate();
+  }
+  for (const auto &old_arena : m_quad_edges) {
+    old_arena->forEach([this, copies](QuadEdge &q) {
+      if (q.alive()) {
+        uint32_t u = m_vertex_rank[q.e[0].Org()];
+        uint32_t v = m_vertex_rank[q.e[2].Org()];
+        QuadEdge *copy = copies + m_reorder_offsets[std::min(u, v)]++;
+        *copy = q;
+        copy->e[0].vertex = u;
+        copy->e[2].vertex = v;
+        q.e[0].next = copy->e;
+      }
+    });
+  }
+  arena->forEach([](QuadEdge &q) {
+    for (Edge &e : q.e) {
+      Edge *target = e.next;
+      Edge *target_copy = (target - target->index())->next;
+      e.next = target_copy + target->index();
+    }
   });
+  if (m_hull_edge) {
+    m_hull_edge = (m_hull_edge - m_hull_edge->index())->next +
+                  m_hull_edge->index();
+  }
+
+  // copies become arena 0, the old one is the next spare: other arenas
+  // restart empty (keeping their memory), edge pointer buffers are stale
+  std::swap(m_quad_edges[0], m_reorder_arena);
+  for (auto &a : m_quad_edges) {
+    if (a.get() != arena) {
+      a->reset();
+    }
+  }
+  m_reorder_arena->reset();
+  m_vertex_edge.clear();
+  m_star_edge.clear();
+  m_kruskal_edge_ptrs.clear();
+}
+
+/****************** Kinetic ******************/
+
+template <typename T>
+bool BasicDivideConquer<T>::moveVertices(const int *ids,
+                                         const Point *positions,
+                                         size_t count) {
+  m_revision++;
+  m_num_flips = 0;
+  // collinear points have no triangle to repair
+  if (!hasTriangles()) {
+    for (size_t i = 0; i < count; i++) {
+      m_ordered_points[ids[i]] = positions[i];
+    }
+    recomputeKeepingIds();
+    return false;
+  }
+  buildStarEdges();
+  // stamp of a vertex: its rank in this call, after stamps of older calls
+  m_move_stamp.resize(m_ordered_points.size(), 0);
+  if (m_stamp > UINT32_MAX - count) {
+    std::fill(m_move_stamp.begin(), m_move_stamp.end(), 0);
+    m_stamp = 0;
+  }
+  const uint32_t base = m_stamp;
+  for (size_t i = 0; i < count; i++) {
+    m_move_stamp[ids[i]] = base + static_cast<uint32_t>(i) + 1;
+  }
+  m_stamp += static_cast<uint32_t>(count);
+
+  // one vertex at a time, the others being fixed: the triangulation stays
+  // valid while each one stays in the polygon of its neighbours, others
+  // stay where they are for now. Edges of faces around moved vertices may
+  // not be Delaunay anymore: each is stacked by the last of its end points
+  // or opposite vertices to move. Past as many flips as vertices,
+  // recomputing is as fast.
+  const size_t max_flips = m_ordered_points.size();
+  const Point *points = m_ordered_points.data();
+  m_flip_stack.clear();
+  m_relocated.clear();
+  for (size_t i = 0; i < count; i++) {
+    const int v = ids[i];
+    const uint32_t stamp = base + static_cast<uint32_t>(i) + 1;
+    const Point old_position = m_ordered_points[v];
+    m_ordered_points[v] = positions[i];
+    if (isRemoved(v)) {
+      continue;
+    }
+    if (!validStar(v)) {
+      m_ordered_points[v] = old_position;
+      m_relocated.push_back(i);
+      if (!m_star_edge[v]) {
+        continue;
+      }
+    }
+    Edge *first = m_star_edge[v];
+    Edge *e = first;
+    do {
+      const int w = e->Dest();
+      e->getQuadEdge()->setLenght(lenghtSquared(points[v], points[w]));
+      if (m_move_stamp[w] <= stamp) {
+        m_flip_stack.push_back(e);
+      }
+      Edge *link = e->Lnext();
+      if (m_move_stamp[w] <= stamp && m_move_stamp[link->Dest()] <= stamp) {
+        m_flip_stack.push_back(link);
+      }
+      e = e->Onext();
+    } while (e != first);
+  }
+  bool repaired = restoreDelaunay(max_flips);
+
+  // the others are taken out and inserted at their new position, on a
+  // Delaunay triangulation (walks and holes need it)
+  for (size_t k = 0; k < m_relocated.size() && repaired; k++) {
+    const size_t i = m_relocated[k];
+    detachVertex(ids[i]);
+    repaired = hasTriangles() && restoreDelaunay(max_flips);
+    m_ordered_points[ids[i]] = positions[i];
+    if (repaired) {
+      attachVertex(ids[i]);
+      repaired = restoreDelaunay(max_flips);
+    }
+  }
+  if (!repaired) {
+    for (size_t i : m_relocated) {
+      m_ordered_points[ids[i]] = positions[i];
+    }
+    recomputeKeepingIds();
+    return false;
+  }
+  return true;
+}
+
+template <typename T> void BasicDivideConquer<T>::buildStarEdges() {
+  if (!m_star_edge.empty()) {
+    return;
+  }
+  m_star_edge.assign(m_ordered_points.size(), nullptr);
+  for (const auto &arena : m_quad_edges) {
+    arena->forEach([this](QuadEdge &q) {
+      if (q.alive()) {
+        m_star_edge[q.e[0].Org()] = &q.e[0];
+        m_star_edge[q.e[2].Org()] = &q.e[2];
+      }
+    });
+  }
+}
+
+template <typename T>
+bool BasicDivideConquer<T>::isInnerFace(Edge *e) const {
+  Edge *next = e->Lnext();
+  if (next->Lnext()->Lnext() != e) {
+    return false;
+  }
+  // a hull of 3 vertices makes the outer face a 3-cycle too
+  const Edge *outer = m_hull_edge->Sym();
+  return e != outer && next != outer && next->Lnext() != outer;
+}
+
+template <typename T> bool BasicDivideConquer<T>::validStar(int v) const {
+  Edge *first = m_star_edge[v];
+  if (!first) {
+    return false; // left out by a recomputation
+  }
+  const Point *points = m_ordered_points.data();
+  Edge *e = first;
+  do {
+    Edge *next = e->Lnext();
+    if (isInnerFace(e)) {
+      // triangle still ccw
+      if (!ccw(points[v], points[e->Dest()], points[next->Dest()])) {
+        return false;
+      }
+    } else {
+      // outer face, walked cw around the hull: no left turn at the
+      // corners of v and of its 2 neighbours along the hull
+      Edge *prev = e->Onext()->Sym();
+      Edge *before = prev->Onext()->Sym();
+      if (ccw(points[before->Org()], points[prev->Org()], points[v]) ||
+          ccw(points[prev->Org()], points[v], points[e->Dest()]) ||
+          ccw(points[v], points[e->Dest()], points[next->Dest()])) {
+        return false;
+      }
+    }
+    e = e->Onext();
+  } while (e != first);
+  return true;
+}
+
+template <typename T> void BasicDivideConquer<T>::flipEdge(Edge *e) {
+  Edge *a = e->Oprev();
+  Edge *b = e->Sym()->Oprev();
+  Splice(e, a);
+  Splice(e->Sym(), b);
+  Splice(e, a->Lnext());
+  Splice(e->Sym(), b->Lnext());
+  e->setEndPoints(a->Dest(), b->Dest());
+  e->getQuadEdge()->setLenght(lenghtSquared(m_ordered_points[a->Dest()],
+                                            m_ordered_points[b->Dest()]));
+  // old end points may have had e as their edge
+  m_star_edge[a->Org()] = a;
+  m_star_edge[b->Org()] = b;
+}
+
+template <typename T>
+bool BasicDivideConquer<T>::restoreDelaunay(size_t max_flips) {
+  const Point *points = m_ordered_points.data();
+  while (!m_flip_stack.empty()) {
+    Edge *e = m_flip_stack.back();
+    m_flip_stack.pop_back();
+    // hull edges are never flipped
+    if (!isInnerFace(e) || !isInnerFace(e->Sym())) {
+      continue;
+    }
+    if (!insideCircle(points[e->Sym()->Lnext()->Dest()], points[e->Org()],
+                      points[e->Dest()], points[e->Lnext()->Dest()])) {
+      continue;
+    }
+    if (m_num_flips == max_flips) {
+      m_flip_stack.clear();
+      return false;
+    }
+    flipEdge(e);
+    m_num_flips++;
+    // the 4 sides of the quadrilateral face new opposite vertices
+    m_flip_stack.push_back(e->Lnext());
+    m_flip_stack.push_back(e->Lnext()->Lnext());
+    m_flip_stack.push_back(e->Sym()->Lnext());
+    m_flip_stack.push_back(e->Sym()->Lnext()->Lnext());
+  }
+  return true;
+}
+
+template <typename T> void BasicDivideConquer<T>::recomputeKeepingIds() {
+  // computeTriangulation renumbers vertices in x order: triangulate a copy
+  // of the positions of vertices not removed, then give each new vertex
+  // the smallest id on it
+  const size_t num_ids = m_ordered_points.size();
+  m_kinetic_points.clear();
+  m_kinetic_ids.clear();
+  for (size_t id = 0; id < num_ids; id++) {
+    if (!isRemoved(static_cast<int>(id))) {
+      m_kinetic_points.push_back(m_ordered_points[id]);
+      m_kinetic_ids.push_back(static_cast<int>(id));
+    }
+  }
+  // removed vertices keep their position
+  m_reorder_points.assign(m_ordered_points.begin(), m_ordered_points.end());
+  m_kinetic_input.swap(m_input_to_vertex);
+  m_kinetic_removed.swap(m_removed);
+  computeTriangulation(m_kinetic_points.data(), m_kinetic_points.size(),
+                       m_split);
+
+  m_vertex_rank.resize(m_ordered_points.size());
+  for (size_t k = m_kinetic_ids.size(); k-- > 0;) {
+    m_vertex_rank[m_input_to_vertex[k]] =
+        static_cast<uint32_t>(m_kinetic_ids[k]);
+  }
+  for (const auto &arena : m_quad_edges) {
+    arena->forEach([this](QuadEdge &q) {
+      if (q.alive()) {
+        q.e[0].vertex = m_vertex_rank[q.e[0].vertex];
+        q.e[2].vertex = m_vertex_rank[q.e[2].vertex];
+      }
+    });
+  }
+  for (size_t k = 0; k < m_kinetic_ids.size(); k++) {
+    m_reorder_points[m_kinetic_ids[k]] = m_ordered_points[m_input_to_vertex[k]];
+  }
+  m_ordered_points.swap(m_reorder_points);
+  m_input_to_vertex.swap(m_kinetic_input);
+  m_removed.swap(m_kinetic_removed);
+}
 
-  // loop all edges
-  int node_orig_set = -1;
-  int node_dest_set = -1;
-  for (size_t i = 0; i < valid_edges.size(); i++) {
+/****************** Dynamic ******************/
 
-    // find id of node's set/cluster
-    node_orig_set = findCluster(valid_edges[i]->Org().id, cluster_id);
-    node_dest_set = findCluster(valid_edges[i]->Dest().id, cluster_id);
+template <typename T> int BasicDivideConquer<T>::insert(const Point &input) {
+  m_revision++;
+  m_num_flips = 0;
+  // snapped as computeTriangulation does: then duplicates are equal points
+  const float cell = m_dedup_policy.snap_cell;
+  const Point point(snapCoordinate(input.x, cell),
+                    snapCoordinate(input.y, cell));
+  const int v = static_cast<int>(m_ordered_points.size());
+  if (!hasTriangles()) {
+    // few or collinear vertices: triangulated again with the new one
+    for (int id = 0; id < v; id++) {
+      if (!isRemoved(id) && samePosition(m_ordered_points[id], point)) {
+        return id;
+      }
+    }
+    m_ordered_points.push_back(point);
+    if (!m_removed.empty()) {
+      m_removed.push_back(0);
+    }
+    recomputeKeepingIds();
+    return v;
+  }
+  buildStarEdges();
+  m_ordered_points.push_back(point);
+  m_star_edge.push_back(nullptr);
+  if (!m_removed.empty()) {
+    m_removed.push_back(0);
+  }
+  if (!m_move_stamp.empty()) {
+    m_move_stamp.push_back(0);
+  }
+  m_flip_stack.clear();
+  const int id = attachVertex(v);
+  if (id != v) {
+    m_ordered_points.pop_back();
+    m_star_edge.pop_back();
+    if (!m_removed.empty()) {
+      m_removed.pop_back();
+    }
+    if (!m_move_stamp.empty()) {
+      m_move_stamp.pop_back();
+    }
+    return id;
+  }
+  restoreDelaunay(SIZE_MAX);
+  return v;
+}
 
-    // not in same set already => add
-    if (node_orig_set != node_dest_set) {
-      a_solution.push_back(valid_edges[i]);
+template <typename T> void BasicDivideConquer<T>::remove(int vertex) {
+  m_revision++;
+  m_num_flips = 0;
+  if (m_removed.empty()) {
+    m_removed.assign(m_ordered_points.size(), 0);
+  }
+  m_removed[vertex] = 1;
+  if (!hasTriangles()) {
+    recomputeKeepingIds();
+    return;
+  }
+  buildStarEdges();
+  m_flip_stack.clear();
+  detachVertex(vertex);
+  // the others may be collinear
+  if (!hasTriangles()) {
+    recomputeKeepingIds();
+    return;
+  }
+  restoreDelaunay(SIZE_MAX);
+}
 
-      // union two diffeHelperrent set of points
-      cluster_id[node_orig_set] = cluster_id[node_dest_set];
+template <typename T> int BasicDivideConquer<T>::walkStart(const Point &p) {
+  // ids follow x or the Hilbert curve: evenly spaced ids are spread over
+  // the points, and about cbrt(n) of them balance sampling and walking
+  const Point *points = m_ordered_points.data();
+  const size_t num_ids = m_ordered_points.size();
+  const size_t num_samples = static_cast<size_t>(std::cbrt(num_ids)) + 1;
+  const size_t step = std::max<size_t>(num_ids / num_samples, 1);
+  int best = m_hull_edge->Org();
+  double best_distance = distanceSquared(points[best], p);
+  auto consider = [&](size_t id) {
+    if (!m_star_edge[id]) {
+      return;
+    }
+    double d = distanceSquared(points[id], p);
+    if (d < best_distance) {
+      best = static_cast<int>(id);
+      best_distance = d;
+    }
+  };
+  if (m_walk_hint >= 0 && static_cast<size_t>(m_walk_hint) < num_ids) {
+    consider(m_walk_hint);
+  }
+  for (size_t id = m_jump_offset % step; id < num_ids; id += step) {
+    consider(id);
+  }
+  m_jump_offset++;
+  return best;
+}
 
-      // take minimum distance
-      if (valid_edges[i]->getQuadEdge()->lenght > min_d) {
-        min_d = valid_edges[i]->getQuadEdge()->lenght;
+template <typename T>
+typename BasicDivideConquer<T>::Edge *
+BasicDivideConquer<T>::locateFace(const Point &p, int start) const {
+  const Point *points = m_ordered_points.data();
+  // a triangle around start: there is one, points are not collinear
+  Edge *e = m_star_edge[start];
+  while (!isInnerFace(e)) {
+    e = e->Onext();
+  }
+  // crosses an edge p is strictly right of, until there is none. Such a
+  // walk never loops on a Delaunay triangulation.
+  while (true) {
+    Edge *cross = nullptr;
+    Edge *f = e;
+    for (int k = 0; k < 3; k++, f = f->Lnext()) {
+      if (rightOf(points, p, f)) {
+        cross = f;
+        break;
       }
+    }
+    if (!cross) {
+      return e;
+    }
+    e = cross->Sym();
+    if (!isInnerFace(e)) {
+      return e;
+    }
+  }
+}
 
-      // already connected all edges between nodes
-      if (static_cast<int>(a_solution.size()) == m_num_nodes - 1) {
+template <typename T>
+typename BasicDivideConquer<T>::Edge *
+BasicDivideConquer<T>::fan(int v, Edge *chain, int num_connects) {
+  Edge *base = makeEdge();
+  base->setEndPoints(chain->Org(), v);
+  base->getQuadEdge()->setLenght(
+      lenghtSquared(m_ordered_points[chain->Org()], m_ordered_points[v]));
+  Splice(base, chain);
+  Edge *first = base;
+  for (int k = 0; k < num_connects; k++) {
+    base = connect(chain, base->Sym());
+    chain = base->Oprev();
+  }
+  return first;
+}
+
+template <typename T> int BasicDivideConquer<T>::attachVertex(int v) {
+  const Point *points = m_ordered_points.data();
+  const Point &p = points[v];
+  Edge *e = locateFace(p, walkStart(p));
+  Edge *chain = e;
+  int num_connects = 2;
+  bool on_hull = false;
+  if (!isInnerFace(e)) {
+    // strictly outside (no vertex there): connected to all hull edges it
+    // sees
+    while (leftOf(points, p, e->Onext()->Sym())) {
+      e = e->Onext()->Sym();
+    }
+    chain = e;
+    num_connects = 0;
+    for (Edge *g = e; leftOf(points, p, g); g = g->Lnext()) {
+      num_connects++;
+    }
+    on_hull = true;
+  } else {
+    Edge *f = e;
+    for (int k = 0; k < 3; k++, f = f->Lnext()) {
+      if (samePosition(points[f->Org()], p)) {
+        return f->Org();
+      }
+    }
+    // on an edge: it is deleted, its 2 faces (or its face and the outer
+    // face) becoming one
+    for (int k = 0; k < 3; k++, f = f->Lnext()) {
+      if (!leftOf(points, p, f)) {
+        chain = f->Lnext();
+        on_hull = !isInnerFace(f->Sym());
+        num_connects = on_hull ? 2 : 3;
+        disconnectEdge(f);
         break;
       }
     }
   }
+  Edge *first = fan(v, chain, num_connects)->Sym();
+  if (on_hull) {
+    m_hull_edge = first;
+  }
+  m_star_edge[v] = first;
+  m_walk_hint = v;
+  // edges of the new star and of its polygon. A deleted edge may have been
+  // the edge of its end points: neighbours get their edge to v.
+  e = first;
+  do {
+    m_star_edge[e->Dest()] = e->Sym();
+    m_flip_stack.push_back(e);
+    m_flip_stack.push_back(e->Lnext());
+    e = e->Onext();
+  } while (e != first);
+  return v;
+}
+
+template <typename T> void BasicDivideConquer<T>::detachVertex(int v) {
+  Edge *first = m_star_edge[v];
+  if (!first) {
+    return;
+  }
+  // edges of the hole: third edges of the faces around v, ccw, starting
+  // after the outer face for a hull vertex
+  bool closed = true;
+  int degree = 0;
+  Edge *start = first;
+  Edge *e = first;
+  do {
+    if (!isInnerFace(e)) {
+      closed = false;
+      start = e->Onext();
+    }
+    degree++;
+    e = e->Onext();
+  } while (e != first);
+  m_hole.clear();
+  e = start;
+  for (int k = 0; k < degree; k++) {
+    if (isInnerFace(e)) {
+      m_hole.push_back(e->Lnext());
+    }
+    m_star_edge[e->Dest()] = e->Sym()->Onext();
+    e = e->Onext();
+  }
+  for (int k = 0; k < degree; k++) {
+    Edge *next = e->Onext();
+    disconnectEdge(e);
+    e = next;
+  }
+  m_star_edge[v] = nullptr;
+  fillHole(closed);
+  if (!closed) {
+    m_hull_edge = m_hole.front()->Sym();
+  }
+  m_walk_hint = m_hole.front()->Org();
+}
+
+template <typename T> void BasicDivideConquer<T>::fillHole(bool closed) {
+  const Point *points = m_ordered_points.data();
+  // the polygon of a Delaunay star is triangulated by the Delaunay
+  // triangles of its vertices, which always include an ear
+  const size_t min_edges = closed ? 3 : 1;
+  while (m_hole.size() > min_edges) {
+    const size_t size = m_hole.size();
+    const size_t num_corners = closed ? size : size - 1;
+    bool clipped = false;
+    for (size_t i = 0; i < num_corners && !clipped; i++) {
+      Edge *ab = m_hole[i];
+      Edge *bc = m_hole[(i + 1) % size];
+      const Point &a = points[ab->Org()];
+      const Point &b = points[ab->Dest()];
+      const Point &c = points[bc->Dest()];
+      if (!ccw(a, b, c)) {
+        continue;
+      }
+      bool empty = true;
+      for (size_t k = 0; k <= size && empty; k++) {
+        int w = k < size ? m_hole[k]->Org() : m_hole.back()->Dest();
+        if (w != ab->Org() && w != ab->Dest() && w != bc->Dest()) {
+          empty = !insideCircle(points[w], a, b, c);
+        }
+      }
+      if (!empty) {
+        continue;
+      }
+      Edge *ca = connect(bc, ab);
+      m_flip_stack.push_back(ca);
+      m_hole[i] = ca->Sym();
+      m_hole.erase(m_hole.begin() + (i + 1) % size);
+      clipped = true;
+    }
+    if (!clipped) {
+      break; // outer face convex again
+    }
+  }
+  m_flip_stack.insert(m_flip_stack.end(), m_hole.begin(), m_hole.end());
+}
+
+/****************** Kruksal ******************/
+
+template <typename T>
+float BasicDivideConquer<T>::computeKruskalMinD(
+    std::vector<Edge *> &a_solution) {
+  auto start = std::chrono::steady_clock::now();
+
+  // compact list of alive edges (edges are easier to sort)
+  size_t num_alive = numEdges();
+  m_kruskal_edges.clear();
+  m_kruskal_edges.reserve(num_alive);
+  m_kruskal_edge_ptrs.clear();
+  m_kruskal_edge_ptrs.reserve(num_alive);
+  for (const auto &arena : m_quad_edges) {
+    arena->forEach([this](QuadEdge &q) {
+      if (q.alive()) {
+        m_kruskal_edges.push_back(
+            WeightedEdge{q.e[0].Org(), q.e[0].Dest(), q.lenght()});
+        m_kruskal_edge_ptrs.push_back(q.e);
+      }
+    });
+  }
+
+  m_kruskal.computeSolution(m_kruskal_edges,
+                            static_cast<int>(m_ordered_points.size()));
+  for (uint32_t idx : m_kruskal.retrieveSol()) {
+    a_solution.push_back(m_kruskal_edge_ptrs[idx]);
+  }
+
+  m_phase_times.mst = secondsSince(start);
+  STATS(tracePhase("kruskal",
+                   std::chrono::duration<double>(start - m_stats_start).count(),
+                   m_phase_times.mst);)
 
   // return real dist
+  return m_kruskal.retrieveMinD();
+}
+
+/****************** Boruvka ******************/
+
+template <typename T>
+float BasicDivideConquer<T>::computeBoruvkaMinD(
+    std::vector<Edge *> &a_solution) {
+  auto start = std::chrono::steady_clock::now();
+
+  // one alive edge out of each vertex to start its Onext() ring from
+  vertexEdges(m_vertex_edge);
+  float min_d = m_boruvka.computeSolution(m_vertex_edge, m_pool.get(),
+                                          a_solution);
+  m_phase_times.mst = secondsSince(start);
+  STATS(tracePhase("boruvka",
+                   std::chrono::duration<double>(start - m_stats_start).count(),
+                   m_phase_times.mst);)
   return std::sqrt(min_d);
 }
+
+template <typename T>
+float BasicDivideConquer<T>::computeMinD(std::vector<Edge *> &a_solution) {
+  if (m_mst_backend == MstBackend::Boruvka) {
+    return computeBoruvkaMinD(a_solution);
+  }
+  return computeKruskalMinD(a_solution);
+}
+
+template class BasicQuadEdge<float>;
+template class BasicQuadEdge<double>;
+template class BasicQuadEdge<int32_t>;
+template class BasicEdge<float>;
+template class BasicEdge<double>;
+template class BasicEdge<int32_t>;
+template class BasicDivideConquer<float>;
+template class BasicDivideConquer<double>;
+template class BasicDivideConquer<int32_t>;
+template bool insideCircle(const float2 &, const float2 &, const float2 &,
+                           const float2 &);
+template bool ccw(const float2 &, const float2 &, const float2 &);
+template bool rightOf(const float2 *, const float2 &, const BasicEdge<float> *);
+template bool leftOf(const float2 *, const float2 &, const BasicEdge<float> *);
+template bool isValid(const float2 *, const BasicEdge<float> *,
+                      const BasicEdge<float> *);
+template void Splice(BasicEdge<float> *, BasicEdge<float> *);
+template bool insideCircle(const double2 &, const double2 &, const double2 &,
+                           const double2 &);
+template bool ccw(const double2 &, const double2 &, const double2 &);
+template bool rightOf(const double2 *, const double2 &,
+                      const BasicEdge<double> *);
+template bool leftOf(const double2 *, const double2 &,
+                     const BasicEdge<double> *);
+template bool isValid(const double2 *, const BasicEdge<double> *,
+                      const BasicEdge<double> *);
+template void Splice(BasicEdge<double> *, BasicEdge<double> *);
+template bool insideCircle(const int2 &, const int2 &, const int2 &,
+                           const int2 &);
+template bool ccw(const int2 &, const int2 &, const int2 &);
+template bool rightOf(const int2 *, const int2 &, const BasicEdge<int32_t> *);
+template bool leftOf(const int2 *, const int2 &, const BasicEdge<int32_t> *);
+template bool isValid(const int2 *, const BasicEdge<int32_t> *,
+                      const BasicEdge<int32_t> *);
+template void Splice(BasicEdge<int32_t> *, BasicEdge<int32_t> *);
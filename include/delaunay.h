@@ -1,50 +1,72 @@
 #pragma once
 #include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <memory>
 #include <numeric>
 #include <vector>
 
+#include "arena.h"
+#include "boruvka.h"
+#include "kruskal.h"
+#include "mesh.h"
+#include "preprocess.h"
+#include "reorder.h"
+#include "stats.h"
+#include "thread_pool.h"
+
 #define EPSILON 1e-6
 /************************** Common functions *******************/
-struct int2 {
-  int x;
-  int y;
-
-  int2(int X, int Y) : x(X), y(Y) {}
-  int2() : x(0), y(0) {}
-};
+// coordinates closer than EPSILON are equal, integers only when equal
+template <typename T> inline bool nearlyEqual(T a, T b) {
+  return std::abs(a - b) < EPSILON;
+}
+inline bool nearlyEqual(int32_t a, int32_t b) { return a == b; }
 
-struct float2 {
+/*!
+ * \brief 2d point of coordinates of type T
+ * Instantiated for float (float2, the default), double (double2) and
+ * int32_t (int2).
+ */
+template <typename T> struct Vec2 {
 
-  float x;
-  float y;
+  T x;
+  T y;
 
-  float2(float X, float Y) : x(X), y(Y) {}
-  float2() : x(0), y(0) {}
-  float2(int2 a) : x(float(a.x)), y(float(a.y)) {}
+  Vec2(T X, T Y) : x(X), y(Y) {}
+  Vec2() : x(0), y(0) {}
+  // conversion from other coordinates (integers round towards zero)
+  template <typename U>
+  explicit Vec2(const Vec2<U> &a)
+      : x(static_cast<T>(a.x)), y(static_cast<T>(a.y)) {}
 
   // operators
-  friend std::ostream &operator<<(std::ostream &os, const float2 &v) {
+  friend std::ostream &operator<<(std::ostream &os, const Vec2 &v) {
     os << "(" << v.x << ", " << v.y << ")";
     return os;
   }
 
-  friend bool operator==(const float2 &L, const float2 &R) {
+  friend bool operator==(const Vec2 &L, const Vec2 &R) {
     //  return std::tie(L.x, L.y) == std::tie(R.x, R.y);
-    return ((std::abs(L.x - R.x) < EPSILON) && (std::abs(L.y - R.y) < EPSILON));
+    return nearlyEqual(L.x, R.x) && nearlyEqual(L.y, R.y);
   }
 
-  float2 &operator-=(const float2 &v) {
+  Vec2 &operator-=(const Vec2 &v) {
     this->x -= v.x;
     this->y -= v.y;
     return *this;
   }
 };
 
-inline float2 operator-(const float2 &L, const float2 &R) {
-  return float2(L) -= R;
+typedef Vec2<float> float2;
+typedef Vec2<double> double2;
+typedef Vec2<int32_t> int2;
+
+template <typename T>
+inline Vec2<T> operator-(const Vec2<T> &L, const Vec2<T> &R) {
+  return Vec2<T>(L) -= R;
 }
 
 // computes squared euclidean distance between two points
@@ -52,99 +74,305 @@ inline float lenghtSquared(const float2 &a, const float2 &b) {
   auto v = a - b;
   return v.x * v.x + v.y * v.y;
 }
+// other coordinates: computed in double (integer differences are exact),
+// rounded to float like the lenghts of float points
+template <typename T>
+inline float lenghtSquared(const Vec2<T> &a, const Vec2<T> &b) {
+  double dx = double(a.x) - double(b.x);
+  double dy = double(a.y) - double(b.y);
+  return static_cast<float>(dx * dx + dy * dy);
+}
 /************************** Common end ************************/
 
 /*!
  * \brief The Node class containing position and id
  */
-struct Node {
+template <typename T> struct BasicNode {
 
-  Node(){};
-  Node(const float2 &d, int idx) : pos(d), id(idx){};
+  BasicNode(){};
+  BasicNode(const Vec2<T> &d, int idx) : pos(d), id(idx){};
 
-  float2 pos; // node's position
-  int id;     // nodes id = used as index later
+  Vec2<T> pos; // node's position
+  int id;      // nodes id = used as index later
 };
 
-class QuadEdge;
+template <typename T> class BasicQuadEdge;
 
-class Edge {
+/*!
+ * \brief One of the 4 directed edges of a quad-edge
+ *
+ * Edges hold no coordinates: primal edges (e[0], e[2]) store the id of their
+ * origin vertex, whose position is the shared orderedPoints()[id]. Dual edges
+ * (faces are never used) lend the same word to the data of their quad-edge.
+ * Quad-edges are 64 bytes aligned on 64: the rotation index of an edge is in
+ * bits 4-5 of its address, and one quad-edge is one cache line. The layout
+ * does not depend on the coordinate type.
+ */
+template <typename T> class BasicEdge {
 
 public:
-  int index;  // its index of edge inside a quad-edge
-  Edge *next; // points to next edge
-  Node node;  // node of origin for each edge
+  BasicEdge *next; // points to next edge
+  union {
+    int vertex;     // primal edges: origin vertex id
+    float lenght;   // e[1]: lenght squared of the quad-edge
+    uint32_t alive; // e[3]: non zero while in the triangulation
+  };
 
 public:
-  Edge() {}
+  BasicEdge() {}
+
+  // index of the edge inside its quad-edge
+  int index() const { return (address() >> 4) & 3; }
 
   // Basic four operators
   // Return the dual of the current edge, directed from its right to its left.
-  inline Edge *Rot() { return (index < 3) ? this + 1 : this - 3; }
+  inline BasicEdge *Rot() { return inQuad(16); }
   // Return the dual of the current edge, directed from its left to its right.
-  inline Edge *invRot() { return (index > 0) ? this - 1 : this + 3; }
+  inline BasicEdge *invRot() { return inQuad(48); }
   // Return the edge from the destination to the origin of the current edge.
-  inline Edge *Sym() { return (index < 2) ? this + 2 : this - 2; }
+  inline BasicEdge *Sym() {
+    return reinterpret_cast<BasicEdge *>(address() ^ 32);
+  }
+  inline const BasicEdge *Sym() const {
+    return reinterpret_cast<const BasicEdge *>(address() ^ 32);
+  }
   // Return the next ccw edge around (from) the origin of the current edge.
-  inline Edge *Onext() { return next; }
+  inline BasicEdge *Onext() { return next; }
 
   // Return the next cw edge around (from) the origin of the current edge.
-  inline Edge *Oprev() { return Rot()->Onext()->Rot(); }
+  inline BasicEdge *Oprev() { return Rot()->Onext()->Rot(); }
   // Return the ccw edge around the left face following the current edge.
-  inline Edge *Lnext() { return invRot()->Onext()->Rot(); }
+  inline BasicEdge *Lnext() { return invRot()->Onext()->Rot(); }
   // Return the edge around the right face ccw before the current edge.
-  inline Edge *Rprev() { return Sym()->Onext(); }
-
-  // return origin node
-  inline Node Org() { return node; }
-  // return destination node
-  inline Node Dest() { return Sym()->node; }
-  // return origin node position
-  const float2 &Org2d() const { return node.pos; }
-  // return dest node position
-  const float2 &Dest2d() const {
-    return (index < 2) ? ((this + 2)->node.pos) : ((this - 2)->node.pos);
-  }
+  inline BasicEdge *Rprev() { return Sym()->Onext(); }
+
+  // return origin vertex id
+  inline int Org() const { return vertex; }
+  // return destination vertex id
+  inline int Dest() const { return Sym()->vertex; }
 
   /*!
-   * \brief Sets dest and origin nodes of edge
+   * \brief Sets dest and origin vertices of edge
    */
-  void setEndPoints(const Node &ori, const Node &de);
+  void setEndPoints(int org, int dest) {
+    vertex = org;
+    Sym()->vertex = dest;
+  }
 
   /*!
    * \brief Get pointer to father quadEdge
    * \return pointer to father quadEdge of edge
    */
-  QuadEdge *getQuadEdge() { return (QuadEdge *)(this - index); }
+  BasicQuadEdge<T> *getQuadEdge() {
+    return reinterpret_cast<BasicQuadEdge<T> *>(address() & ~uintptr_t(63));
+  }
+
+private:
+  uintptr_t address() const { return reinterpret_cast<uintptr_t>(this); }
+  // edge offset bytes further in the quad-edge, wrapping around
+  BasicEdge *inQuad(uintptr_t offset) {
+    uintptr_t a = address();
+    return reinterpret_cast<BasicEdge *>((a & ~uintptr_t(63)) |
+                                         ((a + offset) & 63));
+  }
 };
 
 /*!
  * \brief The QuadEdge class has 4 representation of an 'edge'
  */
-class QuadEdge {
+template <typename T> class alignas(64) BasicQuadEdge {
 public:
   // Constructor will init all Edges
-  QuadEdge();
+  BasicQuadEdge();
+
+  BasicEdge<T> e[4]; // array containing 2 normal and 2 faces edges
 
-  Edge e[4];    // array containing 2 normal and 2 faces edges
-  float lenght; // lenght squared
-  bool alive;   // true if edge was 'removed'
+  // lenght squared (rounded to float for all coordinates)
+  float lenght() const { return e[1].lenght; }
+  void setLenght(float lenght) { e[1].lenght = lenght; }
+  // false once the edge was removed
+  bool alive() const { return e[3].alive != 0; }
+  void setAlive(bool alive) { e[3].alive = alive; }
 };
 
+typedef BasicNode<float> Node;
+typedef BasicEdge<float> Edge;
+typedef BasicQuadEdge<float> QuadEdge;
+
 /*********************** DivideConquer *************************************/
 
+// how divide and conquer splits points
+enum class SplitStrategy {
+  Vertical,   // halves of the x-sorted points at every level
+  Alternating // Dwyer: vertical and horizontal cuts at alternate levels
+};
+
+// algorithm computing spanning tree of the triangulation
+enum class MstBackend {
+  Kruskal, // sequential, sorts all edges
+  Boruvka  // parallel rounds on the thread pool
+};
+
 /*!
  * \brief The DivideConquer class applies Delaunay Triangulation Divide&Conquer
+ *
+ * Templated on the coordinate type: float (DivideConquer), double and
+ * int32_t. Integer coordinates use exact integer predicates (no filter) and
+ * exact duplicate detection, double keeps its full precision through sort,
+ * duplicates removal and predicates. Spanning tree lenghts are rounded to
+ * float for all of them.
  */
-class DivideConquer {
+template <typename T> class BasicDivideConquer {
+  // drives triangulation and merges strip by strip
+  friend class StreamingDelaunay;
+
 public:
-  DivideConquer(){};
+  typedef Vec2<T> Point;
+  typedef BasicNode<T> Node;
+  typedef BasicEdge<T> Edge;
+  typedef BasicQuadEdge<T> QuadEdge;
+
+  BasicDivideConquer();
+
+  /*!
+   * \brief Sets number of threads used to compute the triangulation
+   * \param num_threads 1 (default) runs sequentially
+   * \param parallel_cutoff sub-problems with less points are not split in
+   * tasks anymore
+   */
+  void setNumThreads(int num_threads, int parallel_cutoff = 16384);
+
+  /*!
+   * \brief Forgets last triangulation, keeping the memory of all buffers
+   * Called by computeTriangulation: an object reused on inputs of similar
+   * sizes stops allocating (when sequential; the pool still allocates its
+   * tasks). Edge pointers taken before become invalid.
+   */
+  void reset();
 
   /*!
    * \brief Computes Divide&Conquer DelaunayTriang from 2d points
    * \param stars_system vector float of 2d points
+   * \param split how points are split
+   */
+  void computeTriangulation(std::vector<Point> const &a_stars_system,
+                            SplitStrategy split = SplitStrategy::Vertical);
+
+  /*!
+   * \brief Computes Divide&Conquer DelaunayTriang from 2d points
+   * \param points array of 2d points (e.g. mapped by PointLoader), not copied
+   * \param num_points number of points
+   * \param split how points are split. Alternating cuts give square-ish
+   * sub-triangulations whose merges create fewer long edges that get deleted
+   * (expected O(n log log n) on uniform points)
+   */
+  void computeTriangulation(const Point *points, size_t num_points,
+                            SplitStrategy split = SplitStrategy::Vertical);
+
+  /*!
+   * \brief Sets how duplicated input points are merged
+   * \param policy rule used by next computeTriangulation
+   */
+  void setDedupPolicy(const DedupPolicy &policy) { m_dedup_policy = policy; }
+
+  /*!
+   * \brief Vertex id of each input point of last computeTriangulation
+   * \return vector of ids (an id being index in orderedPoints())
+   */
+  const std::vector<int> &inputToVertex() const { return m_input_to_vertex; }
+
+  // unique ordered points of last triangulation, indexed by vertex id
+  const std::vector<Point> &orderedPoints() const { return m_ordered_points; }
+
+  /*!
+   * \brief Gets one alive edge out of each vertex of last triangulation
+   * \param vertex_edge output edge indexed by vertex id (null if isolated)
+   */
+  void vertexEdges(std::vector<Edge *> &vertex_edge) const;
+
+  /*!
+   * \brief Renumbers vertices along a Hilbert curve and relayouts edges
+   *
+   * Optional pass after computeTriangulation: orderedPoints() and
+   * inputToVertex() follow the new ids (points are not x-sorted anymore),
+   * and quad edges are moved into one arena, grouped by their smallest end
+   * point. Spatially close vertices and edges become close in memory, which
+   * speeds up the spanning tree, exportMesh and hierarchy queries at large
+   * sizes. Edge pointers taken before become invalid.
+   */
+  void reorderVertices();
+
+  /*!
+   * \brief Moves vertices of last triangulation and repairs it (kinetic)
+   *
+   * Vertices move one at a time: while each one stays inside the polygon
+   * of its neighbours (the hull staying convex), the triangulation stays
+   * valid. Edges around moved vertices are then tested with insideCircle
+   * and flipped until it is Delaunay again, in time proportional to moved
+   * vertices and flips. A vertex leaving its polygon is removed and
+   * inserted again at its new position. Collinear points and too many
+   * flips make the triangulation be recomputed from all positions.
+   * Vertex ids are kept in all cases (a vertex moved onto another one is
+   * then left without edge).
+   * \param ids vertex ids to move, each at most once
+   * \param positions new position of each vertex of ids
+   * \param count number of vertices to move
+   * \return true if repaired by flips, false if recomputed
+   */
+  bool moveVertices(const int *ids, const Point *positions, size_t count);
+
+  /*!
+   * \brief Inserts a point into last triangulation
+   *
+   * The face containing it is found by a walk from the closest of the last
+   * updated vertex and about cbrt(n) vertices spread over ids (jump and
+   * walk): points inserted close to each other walk a few faces, a point
+   * far from the last one costs expected O(cbrt(n)) on uniform points (not
+   * the O(log n) of a DelaunayHierarchy, that the insertion invalidates
+   * anyway). The point is connected to the corners of its face (or to the
+   * hull edges it sees) and edges are flipped until the triangulation is
+   * Delaunay again. Collinear triangulations are recomputed.
+   * \param point new point
+   * \return id of its vertex (orderedPoints().size() before the call), or
+   * the id of the vertex already at this position: the point is snapped and
+   * compared as computeTriangulation does (DedupPolicy)
+   */
+  int insert(const Point &point);
+
+  /*!
+   * \brief Removes a vertex from last triangulation
+   *
+   * Its edges are deleted and the polygon of its neighbours is filled with
+   * Delaunay ears. Ids are not reused: the vertex stays in orderedPoints()
+   * without edge, and computeMinD leaves it alone in its tree.
+   * \param vertex id of a vertex not removed yet
+   */
+  void remove(int vertex);
+
+  // true if vertex was removed since last computeTriangulation
+  bool isRemoved(int vertex) const {
+    return !m_removed.empty() && m_removed[vertex];
+  }
+
+  // edge flips of last moveVertices, insert or remove
+  size_t numFlips() const { return m_num_flips; }
+
+  // changes each time the triangulation does (computeTriangulation,
+  // insert, remove, moveVertices, reorderVertices, releaseEdges)
+  uint64_t revision() const { return m_revision; }
+
+  /*!
+   * \brief Compacts last triangulation into index arrays (in parallel)
+   * \param mesh output adjacency, triangles and convex hull
+   */
+  void exportMesh(TriangulationMesh &mesh);
+
+  /*!
+   * \brief Frees all edges of last triangulation (e.g. once exported)
+   * Edge pointers become invalid and the spanning tree can not be computed
+   * anymore; ordered points are kept.
    */
-  void computeTriangulation(std::vector<float2> const &a_stars_system);
+  void releaseEdges();
 
   /*!
    * \brief Computes Kruskal on triangulation and outputs minimum d and graph
@@ -153,6 +381,45 @@ public:
    */
   float computeKruskalMinD(std::vector<Edge *> &esmt_solution);
 
+  /*!
+   * \brief Computes Boruvka on triangulation and outputs minimum d and graph
+   * \param esmt_solution vector of edges for triangulation on Delaunay
+   * \return same minimum d as computeKruskalMinD
+   */
+  float computeBoruvkaMinD(std::vector<Edge *> &esmt_solution);
+
+  /*!
+   * \brief Sets which algorithm computeMinD uses
+   * \param backend Kruskal (default) or Boruvka
+   */
+  void setMstBackend(MstBackend backend) { m_mst_backend = backend; }
+
+  /*!
+   * \brief Computes spanning tree with selected backend
+   * \param esmt_solution vector of edges for triangulation on Delaunay
+   * \return minimum d
+   */
+  float computeMinD(std::vector<Edge *> &esmt_solution);
+
+  // number of edges deleted during merges
+  size_t numDeletedEdges() const;
+
+  // number of edges of the triangulation
+  size_t numEdges() const;
+
+  // peak memory of edges, in bytes
+  size_t edgeBytes() const;
+
+  // phase times of last computations
+  const PhaseTimes &phaseTimes() const { return m_phase_times; }
+
+  /*!
+   * \brief Statistics of last triangulation (and of last computeMinD)
+   * \return counters per recursion depth and trace events, empty unless
+   * compiled with DELAUNAY_STATS, and phase times
+   */
+  TriangulationStats stats() const;
+
 private:
   /*!
    * \brief Computes recursive Delaunay Triangulation
@@ -160,10 +427,43 @@ private:
    * \param right output pointer edge of most right edge of triangulation
    * \param left_idx input index limiting left side of vector to triangulate
    * \param right_idx input index limiting right side of vector to triang
+   * \param depth recursion depth (statistics only)
    */
   void recursiveDelaunay(Edge *&left, Edge *&right, int left_idx,
-                         int right_idx);
+                         int right_idx, int depth = 0);
+
+  /*!
+   * \brief Computes recursive Delaunay Triangulation with alternating cuts
+   * \param left output ccw hull edge out of the first vertex in axis frame
+   * \param right output cw hull edge out of the last vertex in axis frame
+   * \param begin first node of m_split_nodes to triangulate
+   * \param end node after the last one
+   * \param axis 0: split by a vertical line, 1: by a horizontal line
+   * \param depth recursion depth (statistics only)
+   */
+  void alternatingDelaunay(Edge *&left, Edge *&right, int begin, int end,
+                           int axis, int depth);
 
+  /*!
+   * \brief Triangulates 2 or 3 vertices
+   * \param nodes vertices sorted along the cut frame
+   */
+  void baseDelaunay(Edge *&left, Edge *&right, const Node *nodes,
+                    int num_nodes, int depth);
+
+  /*!
+   * \brief Merges two triangulations separated by a vertical line
+   * \param ldo in/out most left edge of left triangulation (then of result)
+   * \param ldi most right edge of left triangulation
+   * \param rdi most left edge of right triangulation
+   * \param rdo in/out most right edge of right triangulation (then of result)
+   * \param depth recursion depth of the merged halves' parent (statistics)
+   */
+  void mergeHalves(Edge *&ldo, Edge *ldi, Edge *rdi, Edge *&rdo,
+                   int depth = 0);
+
+  // arena of the calling thread
+  Arena<QuadEdge> &localArena();
   // creates an edge (and its quad edge)
   Edge *makeEdge();
   // creates an edge (and its quad edge) from node
@@ -174,46 +474,168 @@ private:
   void disconnectEdge(Edge *e);
   // void deleteEdge(Edge *e);
 
+  // fills m_star_edge if empty (first update since the triangulation)
+  void buildStarEdges();
+  // true if the left face of e is a triangle, not the outer face
+  bool isInnerFace(Edge *e) const;
+  // true if faces around vertex v are still valid at current positions
+  bool validStar(int v) const;
+  // replaces e by the other diagonal of the quadrilateral of its 2 faces
+  void flipEdge(Edge *e);
+  /*!
+   * \brief Flips edges of m_flip_stack, and the ones they uncover, until
+   * all are locally Delaunay
+   * \return false (stack dropped) if more than max_flips are needed
+   */
+  bool restoreDelaunay(size_t max_flips);
+  // triangulates vertices not removed again, vertex ids unchanged
+  void recomputeKeepingIds();
+
+  // true if last triangulation has a triangle (points not collinear)
+  bool hasTriangles() const { return m_hull_edge && isInnerFace(m_hull_edge); }
+  // vertex to walk from towards p: closest of the hint and of samples
+  int walkStart(const Point &p);
+  /*!
+   * \brief Visibility walk from vertex start to the face containing p
+   * \return edge whose left face is the triangle containing p (maybe on
+   * its boundary), or hull edge (outer face on the left) p is left of
+   */
+  Edge *locateFace(const Point &p, int start) const;
+  /*!
+   * \brief Connects vertex v to the origins of the edges of a chain
+   * \param chain first edge of the chain, v being in its left face
+   * \param num_connects edges added after the first one: edges of the chain
+   * minus 1 if it closes the face, edges of the chain otherwise
+   * \return first edge, from the origin of chain to v
+   */
+  Edge *fan(int v, Edge *chain, int num_connects);
+  /*!
+   * \brief Adds vertex v at its position to the triangulation, edges to
+   * flip being stacked
+   * \return v, or the vertex already at its position (v has no edge then)
+   */
+  int attachVertex(int v);
+  // deletes edges of vertex v and fills the hole, edges to flip stacked
+  void detachVertex(int v);
+  /*!
+   * \brief Triangulates the left face of the edges of m_hole with ears
+   * whose circumcircle has no vertex of the hole inside
+   * \param closed true if the edges close the face (hole of an inner
+   * vertex), false if it is the outer face: then only left turns are filled
+   */
+  void fillHole(bool closed);
+
+#ifdef DELAUNAY_STATS
+  // counters of the calling thread when a recorded section started
+  struct StatsMark {
+    uint64_t incircle_calls;
+    uint64_t ccw_calls;
+    size_t allocated;
+    size_t released;
+    std::chrono::steady_clock::time_point begin;
+  };
+  StatsMark markStats();
+  // adds counters since mark to depth stats of the calling thread, and a
+  // trace event named name (if not null) for top depths
+  DepthStats &recordStats(const StatsMark &mark, int depth, const char *name);
+  // adds a phase trace event on calling thread, begin being in seconds
+  // since the start of the triangulation
+  void tracePhase(const char *name, double begin, double duration);
+  void resetStats();
+#endif
+
 private:
-  // vector of all memory created quad edges
-  std::vector<std::shared_ptr<QuadEdge>> m_quad_edges;
-  // unique ordered points
-  std::vector<float2> m_ordered_points;
-  // number of nodes added to Delaunay
-  int m_num_nodes = 0;
-  // number of edges 'deleted'
-  int m_num_deleted_edges = 0;
+  // one arena per thread owning all quad edges, dead ones are recycled
+  std::vector<std::unique_ptr<Arena<QuadEdge>>> m_quad_edges;
+  // sorting and duplicates removal of input points
+  PointPreprocessor m_preprocess;
+  DedupPolicy m_dedup_policy;
+  // unique ordered points, node id = index inside
+  std::vector<Point> m_ordered_points;
+  // vertex id of each input point
+  std::vector<int> m_input_to_vertex;
+  // pool running both halves of the recursion, null when sequential
+  std::unique_ptr<ThreadPool> m_pool;
+  // vertices permuted by alternating cuts (ids are unchanged)
+  std::vector<Node> m_split_nodes;
+  // minimum number of points of a sub-problem to be split in tasks
+  int m_parallel_cutoff = 16384;
+  // spanning tree
+  MstBackend m_mst_backend = MstBackend::Kruskal;
+  Kruskal m_kruskal;
+  std::vector<WeightedEdge> m_kruskal_edges; // alive edges as (u, v, lenght)
+  std::vector<Edge *> m_kruskal_edge_ptrs;   // same order as m_kruskal_edges
+  BasicBoruvka<T> m_boruvka;
+  std::vector<Edge *> m_vertex_edge; // one alive edge out of each vertex
+  // export: triangles owned by each vertex, flag per adjacency slot
+  std::vector<uint32_t> m_triangle_offsets;
+  std::vector<char> m_triangle_slot;
+  // ccw hull edge, out of the leftmost vertex unless updates moved it
+  Edge *m_hull_edge = nullptr;
+  // reorder buffers
+  HilbertOrder m_hilbert;
+  std::vector<uint32_t> m_vertex_rank; // new id of each old id
+  std::vector<Point> m_reorder_points;
+  std::vector<uint32_t> m_reorder_offsets;
+  std::unique_ptr<Arena<QuadEdge>> m_reorder_arena; // spare, swapped in
+  // kinetic updates
+  SplitStrategy m_split = SplitStrategy::Vertical; // of last triangulation
+  std::vector<Edge *> m_star_edge;  // one edge out of each vertex, or empty
+  std::vector<Edge *> m_flip_stack; // edges to test
+  std::vector<size_t> m_relocated;  // moves out of the vertex polygon
+  std::vector<uint32_t> m_move_stamp; // order of a vertex in moves
+  uint32_t m_stamp = 0;               // stamps given by previous moves
+  std::vector<Point> m_kinetic_points; // recomputation input
+  std::vector<int> m_kinetic_ids;      // id of each of them
+  std::vector<int> m_kinetic_input;    // caller mapping, kept aside
+  std::vector<uint8_t> m_kinetic_removed; // removal flags, kept aside
+  size_t m_num_flips = 0;
+  uint64_t m_revision = 0; // modifications so far
+  // dynamic updates
+  std::vector<uint8_t> m_removed; // flag per vertex id, or empty
+  std::vector<Edge *> m_hole;     // boundary of a removed vertex's star
+  int m_walk_hint = -1;           // last updated vertex
+  size_t m_jump_offset = 0;       // first sampled id, rotated per walk
+  PhaseTimes m_phase_times;
+#ifdef DELAUNAY_STATS
+  // per worker, written by its own thread only
+  std::vector<std::vector<DepthStats>> m_depth_stats; // then per depth
+  std::vector<std::vector<TraceEvent>> m_trace_events;
+  std::chrono::steady_clock::time_point m_stats_start;
+  PredicateCounters m_predicates_start;
+  PredicateCounters m_predicates;
+#endif
 };
 
+typedef BasicDivideConquer<float> DivideConquer;
+
 /*********** Operators for Data Structure *************/
 // Returns twice the area of the oriented triangle (a, b, c)
 inline float computeArea(const float2 &a, const float2 &b, const float2 &c) {
   return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
 }
-// Return true if point P inside triangle abc
-bool insideCircle(const float2 &p, const float2 &a, const float2 &b,
-                  const float2 &c);
+// Return true if point P strictly inside circumcircle of ccw triangle abc
+// (exact, see predicates.h)
+template <typename T>
+bool insideCircle(const Vec2<T> &p, const Vec2<T> &a, const Vec2<T> &b,
+                  const Vec2<T> &c);
 
-// Returns true if the points a, b, c are in a counterclockwise order
-bool ccw(const float2 &a, const float2 &b, const float2 &c);
+// Returns true if the points a, b, c are in a counterclockwise order (exact)
+template <typename T>
+bool ccw(const Vec2<T> &a, const Vec2<T> &b, const Vec2<T> &c);
 
-// True if p is right of edge e
-bool rightOf(const float2 &p, Edge *e);
+// True if p is right of edge e, of vertices in points
+template <typename T>
+bool rightOf(const Vec2<T> *points, const Vec2<T> &p, const BasicEdge<T> *e);
 
-// True if p is left of edge e
-bool leftOf(const float2 &p, Edge *e);
+// True if p is left of edge e, of vertices in points
+template <typename T>
+bool leftOf(const Vec2<T> *points, const Vec2<T> &p, const BasicEdge<T> *e);
 
-// Checks whether the edge e is above basel
-bool isValid(Edge *e, Edge *basel);
+// Checks whether the edge e is above basel, of vertices in points
+template <typename T>
+bool isValid(const Vec2<T> *points, const BasicEdge<T> *e,
+             const BasicEdge<T> *basel);
 
 // operator for split and connect edges
-void Splice(Edge *a, Edge *b);
-
-/*** for Kruskal ****/
-/*!
- * \brief Find cluster id (parent of all clusters) recursively
- * \param index of a node
- * \param vector of ids of clusters
- * \return int id of cluster for node index
- */
-int findCluster(int idx, const std::vector<int> &a_cluster);
+template <typename T> void Splice(BasicEdge<T> *a, BasicEdge<T> *b);
@@ -0,0 +1,151 @@
+#include "dendrogram.h"
+#include "delaunay.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+// queries per task of batched calls
+const size_t kGrain = 1 << 12;
+
+} // namespace
+
+uint32_t Dendrogram::findSet(uint32_t i) {
+  while (m_set_parent[i] != i) {
+    m_set_parent[i] = m_set_parent[m_set_parent[i]];
+    i = m_set_parent[i];
+  }
+  return i;
+}
+
+template <typename T>
+void Dendrogram::build(const std::vector<BasicEdge<T> *> &tree,
+                       size_t num_vertices) {
+  m_num_vertices = num_vertices;
+
+  // edges by increasing lenght (non negative floats compare like their bits),
+  // already sorted when coming from Kruskal
+  m_keys.resize(tree.size());
+  for (size_t i = 0; i < tree.size(); i++) {
+    float lenght = tree[i]->getQuadEdge()->lenght();
+    uint32_t bits;
+    std::memcpy(&bits, &lenght, sizeof(bits));
+    m_keys[i] = (uint64_t(bits) << 32) | i;
+  }
+  if (!std::is_sorted(m_keys.begin(), m_keys.end())) {
+    std::sort(m_keys.begin(), m_keys.end());
+  }
+
+  m_parent.resize(num_vertices);
+  m_height.assign(num_vertices, 0.0f);
+  m_size.assign(num_vertices, 1);
+  m_set_parent.resize(num_vertices);
+  m_set_node.resize(num_vertices);
+  for (uint32_t v = 0; v < num_vertices; v++) {
+    m_parent[v] = v;
+    m_set_parent[v] = v;
+    m_set_node[v] = v;
+  }
+
+  // Kruskal: each accepted edge creates the parent of the clusters it links
+  for (uint64_t key : m_keys) {
+    BasicEdge<T> *e = tree[uint32_t(key)];
+    uint32_t a = findSet(static_cast<uint32_t>(e->Org()));
+    uint32_t b = findSet(static_cast<uint32_t>(e->Dest()));
+    if (a == b) {
+      continue;
+    }
+    uint32_t node = static_cast<uint32_t>(m_parent.size());
+    uint32_t left = m_set_node[a];
+    uint32_t right = m_set_node[b];
+    m_parent[left] = node;
+    m_parent[right] = node;
+    m_parent.push_back(node);
+    m_height.push_back(std::sqrt(e->getQuadEdge()->lenght()));
+    m_size.push_back(m_size[left] + m_size[right]);
+
+    // union by size
+    if (m_size[left] < m_size[right]) {
+      std::swap(a, b);
+    }
+    m_set_parent[b] = a;
+    m_set_node[a] = node;
+  }
+
+  // jump pointers, parents first (parents have larger ids): the jump of a
+  // node skips 2^k - 1 ancestors so that any ancestor is O(log n) steps away
+  const size_t num_nodes = m_parent.size();
+  m_jump.resize(num_nodes);
+  m_depth.resize(num_nodes);
+  for (size_t i = num_nodes; i-- > 0;) {
+    uint32_t p = m_parent[i];
+    if (p == i) {
+      m_jump[i] = p;
+      m_depth[i] = 0;
+      continue;
+    }
+    uint32_t j = m_jump[p];
+    m_depth[i] = m_depth[p] + 1;
+    m_jump[i] = (m_depth[p] - m_depth[j] == m_depth[j] - m_depth[m_jump[j]])
+                    ? m_jump[j]
+                    : p;
+  }
+}
+
+size_t Dendrogram::numClusters(float radius) const {
+  // internal nodes are sorted by height
+  auto first = m_height.begin() + m_num_vertices;
+  size_t merges = std::upper_bound(first, m_height.end(), radius) - first;
+  return m_num_vertices - merges;
+}
+
+uint32_t Dendrogram::cluster(uint32_t vertex, float radius) const {
+  uint32_t node = vertex;
+  while (m_parent[node] != node && m_height[m_parent[node]] <= radius) {
+    uint32_t jump = m_jump[node];
+    node = (m_height[jump] <= radius) ? jump : m_parent[node];
+  }
+  return node;
+}
+
+float Dendrogram::radiusForClusters(size_t num_clusters) const {
+  size_t num_merges = numNodes() - m_num_vertices;
+  if (num_clusters >= m_num_vertices) {
+    return 0.0f;
+  }
+  size_t merges = m_num_vertices - num_clusters;
+  if (merges > num_merges) {
+    return std::numeric_limits<float>::infinity();
+  }
+  return m_height[m_num_vertices + merges - 1];
+}
+
+void Dendrogram::numClusters(const float *radii, size_t num_radii,
+                             size_t *counts, ThreadPool *pool) const {
+  auto body = [this, radii, counts](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      counts[i] = numClusters(radii[i]);
+    }
+  };
+  ThreadPool::forRange(pool, num_radii, kGrain, body);
+}
+
+void Dendrogram::clusters(float radius, uint32_t *labels,
+                          ThreadPool *pool) const {
+  auto body = [this, radius, labels](size_t begin, size_t end) {
+    for (size_t v = begin; v < end; v++) {
+      labels[v] = cluster(static_cast<uint32_t>(v), radius);
+    }
+  };
+  ThreadPool::forRange(pool, m_num_vertices, kGrain, body);
+}
+
+template void Dendrogram::build(const std::vector<BasicEdge<float> *> &,
+                                size_t);
+template void Dendrogram::build(const std::vector<BasicEdge<double> *> &,
+                                size_t);
+template void Dendrogram::build(const std::vector<BasicEdge<int32_t> *> &,
+                                size_t);
@@ -0,0 +1,104 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "thread_pool.h"
+
+template <typename T> class BasicEdge;
+
+/*!
+ * \brief Single-linkage dendrogram (Kruskal reconstruction tree)
+ *
+ * Built once from a spanning tree of the triangulation: leaves are the
+ * vertices (node ids [0, numVertices())), and every tree edge, by increasing
+ * lenght, creates an internal node (ids from numVertices()) parent of the
+ * two clusters it links. Heights (euclidean lenght of the merging edge) grow
+ * towards the root, and internal node ids grow with their height.
+ *
+ * At a radius r, two vertices are in the same cluster when a path of edges
+ * not longer than r links them: the cluster of a vertex is its highest
+ * ancestor of height <= r. Ancestors are searched with skew-binary jump
+ * pointers (one per node, O(log n) steps), the number of clusters with a
+ * binary search on heights. Queries are const: any number of threads may
+ * query concurrently.
+ */
+class Dendrogram {
+public:
+  /*!
+   * \brief Builds the tree (forest if not connected) from spanning edges
+   * \param tree edges of the spanning tree, in any order (e.g. computeMinD)
+   * \param num_vertices number of vertices of the triangulation
+   */
+  template <typename T>
+  void build(const std::vector<BasicEdge<T> *> &tree, size_t num_vertices);
+
+  size_t numVertices() const { return m_num_vertices; }
+  // vertices then internal nodes
+  size_t numNodes() const { return m_parent.size(); }
+
+  // parent node, itself for a root
+  uint32_t parent(uint32_t node) const { return m_parent[node]; }
+  // lenght of the edge merging the node, 0 for a vertex
+  float height(uint32_t node) const { return m_height[node]; }
+  // number of vertices under node
+  uint32_t clusterSize(uint32_t node) const { return m_size[node]; }
+
+  /*!
+   * \brief Number of clusters when linking vertices closer than radius
+   * \param radius euclidean distance, inclusive
+   */
+  size_t numClusters(float radius) const;
+
+  /*!
+   * \brief Cluster of a vertex at radius
+   * \param vertex vertex id
+   * \param radius euclidean distance, inclusive
+   * \return node id of the cluster (vertex itself if alone), same for all
+   * vertices of the cluster
+   */
+  uint32_t cluster(uint32_t vertex, float radius) const;
+
+  /*!
+   * \brief Smallest radius giving at most num_clusters clusters
+   * \return infinity if the forest has more trees than num_clusters
+   */
+  float radiusForClusters(size_t num_clusters) const;
+
+  /*!
+   * \brief Number of clusters at many radii
+   * \param radii radii, in any order
+   * \param num_radii number of radii
+   * \param counts output clusters of each radius
+   * \param pool optional pool to split the batch on (may be null)
+   */
+  void numClusters(const float *radii, size_t num_radii, size_t *counts,
+                   ThreadPool *pool = nullptr) const;
+
+  /*!
+   * \brief Cluster of all vertices at radius
+   * \param radius euclidean distance, inclusive
+   * \param labels output node id of cluster of each vertex, numVertices()
+   * entries
+   * \param pool optional pool to split vertices on (may be null)
+   */
+  void clusters(float radius, uint32_t *labels,
+                ThreadPool *pool = nullptr) const;
+
+private:
+  // root of the union-find set of a vertex, halving path on the way
+  uint32_t findSet(uint32_t i);
+
+private:
+  size_t m_num_vertices = 0;
+  std::vector<uint32_t> m_parent;
+  std::vector<uint32_t> m_jump; // ancestor at a skew-binary distance
+  std::vector<float> m_height;
+  std::vector<uint32_t> m_size;
+
+  // build buffers
+  std::vector<uint64_t> m_keys; // lenght bits (high word) then edge index
+  std::vector<uint32_t> m_depth;
+  std::vector<uint32_t> m_set_parent;
+  std::vector<uint32_t> m_set_node; // per set root: node of the cluster
+};
@@ -1,68 +1,120 @@
 #include "kruskal.h"
 
-Kruskal::Kruskal(const std::vector<Edge *> &e_stack, int num_nodes) {
-  // init
-  min_d = 0;
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric> //std::iota
 
-  // generate unique sets for each node
-  parent.resize(num_node);
-  std::iota(std::begin(parent), std::end(parent), 0);
-
-  // get vailable edge vector
-  std::vector<Edge *> valid_edges;
-  valid_edges.reserve(edge_stack.size());
-  for (auto i : edge_stack) {
-    if (i->Qedge()->alive) {
-      valid_edges.push_back(i);
-    }
-  }
+namespace {
 
-  std::sort(valid_edges.begin(), valid_edges.end(), [](Edge *i, Edge *j) {
-    return (i->Qedge()->lenght < j->Qedge()->lenght);
-  });
+const int kDigitBits = 11;
+const uint32_t kBuckets = 1u << kDigitBits;
+const int kNumPasses = (32 + kDigitBits - 1) / kDigitBits;
 
-  // loop all edges
-  int node_orig_set = 0;
-  int node_dest_set = 0;
-  for (int i = 0; i < valid_edges.size(); i++) {
+inline uint32_t lenghtKey(float lenght) {
+  uint32_t bits;
+  std::memcpy(&bits, &lenght, sizeof(bits));
+  return bits;
+}
 
-    if (!valid_edges[i]->Qedge()->alive) {
-      continue;
-    }
+} // namespace
+
+float Kruskal::computeSolution(const std::vector<WeightedEdge> &edges,
+                               int num_nodes) {
+  // init
+  m_solution.clear();
+  float min_d = 0;
+  if (num_nodes < 2) {
+    m_min_d = 0;
+    return 0;
+  }
+
+  // generate unique sets for each node
+  m_parent.resize(num_nodes);
+  std::iota(m_parent.begin(), m_parent.end(), 0);
+  m_rank.assign(num_nodes, 0);
 
-    //
-    node_orig_set = findSet(valid_edges[i]->Org().id);
-    node_dest_set = findSet(valid_edges[i]->Dest().id);
+  sortEdges(edges);
+
+  // loop edges by increasing lenght
+  const size_t tree_size = static_cast<size_t>(num_nodes) - 1;
+  for (uint32_t idx : m_order) {
+    int u = findSet(edges[idx].u);
+    int v = findSet(edges[idx].v);
 
     // not in same set already
-    if (node_orig_set != node_dest_set) {
-      solution.push_back(valid_edges[i]); // add to tree
-      // union two different set of points
-      parent[node_orig_set] = parent[node_dest_set];
-
-      // take minimym distance
-      if (edge_stack[i]->Qedge()->lenght > min_d) {
-        min_d = valid_edges[i]->Qedge()->lenght;
+    if (u != v) {
+      // union by rank: attach smaller tree under bigger one
+      if (m_rank[u] < m_rank[v]) {
+        std::swap(u, v);
+      }
+      m_parent[v] = u;
+      if (m_rank[u] == m_rank[v]) {
+        m_rank[u]++;
       }
 
-      if (solution.size() == num_node - 1) {
+      m_solution.push_back(idx);
+      min_d = edges[idx].lenght; // sorted: always the maximum
+
+      // all nodes connected
+      if (m_solution.size() == tree_size) {
         break;
       }
     }
   }
 
   // get real dist
-  min_d = std::sqrt(min_d);
-};
+  m_min_d = std::sqrt(min_d);
+  return m_min_d;
+}
 
-int Kruskal::findSet(int i) {
-  if (i == parent[i]) {
-    return i;
-  } else {
-    return findSet(parent[i]);
+void Kruskal::sortEdges(const std::vector<WeightedEdge> &edges) {
+  const size_t n = edges.size();
+  m_keys.resize(n);
+  m_order.resize(n);
+  m_keys_tmp.resize(n);
+  m_order_tmp.resize(n);
+  for (size_t i = 0; i < n; i++) {
+    m_keys[i] = lenghtKey(edges[i].lenght);
+    m_order[i] = static_cast<uint32_t>(i);
   }
-}
 
-void Kruskal::computeSolution(){
+  uint32_t histogram[kBuckets];
+  for (int pass = 0; pass < kNumPasses; pass++) {
+    const int shift = pass * kDigitBits;
+
+    std::fill(histogram, histogram + kBuckets, 0);
+    for (size_t i = 0; i < n; i++) {
+      histogram[(m_keys[i] >> shift) & (kBuckets - 1)]++;
+    }
+
+    // a digit shared by all keys leaves the order unchanged: skip the pass
+    bool skip = false;
+    uint32_t offset = 0;
+    for (uint32_t b = 0; b < kBuckets; b++) {
+      uint32_t count = histogram[b];
+      skip = skip || (count == n);
+      histogram[b] = offset;
+      offset += count;
+    }
+    if (skip) {
+      continue;
+    }
 
-};
+    for (size_t i = 0; i < n; i++) {
+      uint32_t dst = histogram[(m_keys[i] >> shift) & (kBuckets - 1)]++;
+      m_keys_tmp[dst] = m_keys[i];
+      m_order_tmp[dst] = m_order[i];
+    }
+    m_keys.swap(m_keys_tmp);
+    m_order.swap(m_order_tmp);
+  }
+}
+
+int Kruskal::findSet(int i) {
+  while (m_parent[i] != i) {
+    m_parent[i] = m_parent[m_parent[i]];
+    i = m_parent[i];
+  }
+  return i;
+}
@@ -1,28 +1,60 @@
 #pragma once
 
-#include "delaunay.h"
-#include <algorithm>
-
-#include <numeric> //std::iota
+#include <cstdint>
 #include <vector>
 
+/*!
+ * \brief Edge of a graph given to Kruskal
+ */
+struct WeightedEdge {
+  int u;        // first node id
+  int v;        // second node id
+  float lenght; // lenght squared (>= 0)
+};
+
+/*!
+ * \brief Kruskal minimum spanning tree on a compact edge list
+ *
+ * Edges are ordered by a LSD radix sort on the bits of their lenght (non
+ * negative floats compare like their bits), then accepted through an
+ * iterative union-find with path halving and union by rank, stopping once
+ * num_nodes - 1 edges are accepted. Buffers are kept between calls.
+ */
 class Kruskal {
 public:
-  Kruskal(const std::vector<Edge *> &e_stack, int num_nodes);
+  /*!
+   * \brief Computes minimum spanning tree (forest if graph not connected)
+   * \param edges edge list, node ids in [0, num_nodes)
+   * \param num_nodes number of nodes
+   * \return euclidean lenght of the longest accepted edge, as
+   * retrieveMinD()
+   */
+  float computeSolution(const std::vector<WeightedEdge> &edges,
+                        int num_nodes);
 
-  void computeSolution();
-  inline std::vector<Edge *> &retrieveSol() { return solution; }
-  inline float retrieveMinD() { return min_d; }
-
-  std::vector<Edge *> edge_stack;
+  // indices in edges of accepted edges, by increasing lenght
+  inline const std::vector<uint32_t> &retrieveSol() const {
+    return m_solution;
+  }
+  // euclidean lenght of the longest accepted edge
+  inline float retrieveMinD() const { return m_min_d; }
 
 private:
-  // looks for set by checking parent
+  // sorts m_order by lenght of edges
+  void sortEdges(const std::vector<WeightedEdge> &edges);
+  // looks for set by checking parent, halving path on the way
   int findSet(int i);
 
 private:
-  std::vector<Edge *> solution;
-  std::vector<int> parent;
-  int num_node;
-  float min_d;
+  std::vector<uint32_t> m_solution;
+  float m_min_d = 0;
+
+  // sort buffers
+  std::vector<uint32_t> m_keys;
+  std::vector<uint32_t> m_order;
+  std::vector<uint32_t> m_keys_tmp;
+  std::vector<uint32_t> m_order_tmp;
+  // union-find
+  std::vector<int> m_parent;
+  std::vector<uint8_t> m_rank;
 };
@@ -0,0 +1,295 @@
+#include "loader.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// text below this size is parsed by a single chunk
+const size_t kMinParallelBytes = 1 << 20;
+// chunks per thread: evens out lines of different lengths
+const size_t kChunksPerThread = 4;
+
+const double kPow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                         1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                         1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+inline bool isSeparator(char c) {
+  return c == ' ' || c == '\t' || c == ',' || c == ';' || c == '\r';
+}
+
+inline double scale10(double value, int exp10) {
+  if (exp10 >= 0) {
+    return exp10 <= 22 ? value * kPow10[exp10] : value * std::pow(10.0, exp10);
+  }
+  return exp10 >= -22 ? value / kPow10[-exp10] : value * std::pow(10.0, exp10);
+}
+
+// parses a decimal number at s (never reads at or past end)
+bool parseNumber(const char *&s, const char *end, double &value) {
+  const char *c = s;
+  bool negative = false;
+  if (c < end && (*c == '-' || *c == '+')) {
+    negative = *c == '-';
+    c++;
+  }
+
+  uint64_t mantissa = 0;
+  int digits = 0; // significant digits in mantissa
+  int exp10 = 0;
+  bool any = false;
+  for (; c < end && isDigit(*c); c++, any = true) {
+    if (digits < 19) {
+      mantissa = mantissa * 10 + (*c - '0');
+      digits += (mantissa != 0);
+    } else {
+      exp10++;
+    }
+  }
+  if (c < end && *c == '.') {
+    for (c++; c < end && isDigit(*c); c++, any = true) {
+      if (digits < 19) {
+        mantissa = mantissa * 10 + (*c - '0');
+        digits += (mantissa != 0);
+        exp10--;
+      }
+    }
+  }
+  if (!any) {
+    return false;
+  }
+  if (c < end && (*c == 'e' || *c == 'E')) {
+    const char *e = c + 1;
+    bool exp_negative = false;
+    if (e < end && (*e == '-' || *e == '+')) {
+      exp_negative = *e == '-';
+      e++;
+    }
+    if (e < end && isDigit(*e)) {
+      int exponent = 0;
+      for (; e < end && isDigit(*e); e++) {
+        exponent = std::min(exponent * 10 + (*e - '0'), 9999);
+      }
+      exp10 += exp_negative ? -exponent : exponent;
+      c = e;
+    }
+  }
+
+  value = scale10(double(mantissa), exp10);
+  if (negative) {
+    value = -value;
+  }
+  s = c;
+  return true;
+}
+
+// parses x and y at the start of a line, false for headers and comments
+bool parseLine(const char *s, const char *end, float2 &point) {
+  while (s < end && isSeparator(*s)) {
+    s++;
+  }
+  double x;
+  double y;
+  if (!parseNumber(s, end, x)) {
+    return false;
+  }
+  if (s == end || !isSeparator(*s)) {
+    return false;
+  }
+  while (s < end && isSeparator(*s)) {
+    s++;
+  }
+  if (!parseNumber(s, end, y)) {
+    return false;
+  }
+  point = float2(float(x), float(y));
+  return true;
+}
+
+size_t countLines(const char *begin, const char *end) {
+  size_t count = 0;
+  for (const char *s = begin; s < end; s++) {
+    s = static_cast<const char *>(std::memchr(s, '\n', end - s));
+    if (!s) {
+      break;
+    }
+    count++;
+  }
+  return count + 1; // last line may miss its newline
+}
+
+} // namespace
+
+PointLoader::~PointLoader() { unmap(); }
+
+void PointLoader::map(const std::string &path) {
+  unmap();
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("PointLoader: cannot open " + path);
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    throw std::runtime_error("PointLoader: cannot stat " + path);
+  }
+  m_map_size = static_cast<size_t>(st.st_size);
+  if (m_map_size > 0) {
+    void *map = ::mmap(nullptr, m_map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+      ::close(fd);
+      m_map_size = 0;
+      throw std::runtime_error("PointLoader: cannot map " + path);
+    }
+    ::madvise(map, m_map_size, MADV_SEQUENTIAL);
+    m_map = static_cast<const char *>(map);
+  }
+  ::close(fd); // mapping stays valid
+}
+
+void PointLoader::unmap() {
+  if (m_map) {
+    ::munmap(const_cast<char *>(m_map), m_map_size);
+  }
+  m_map = nullptr;
+  m_map_size = 0;
+}
+
+PointSpan PointLoader::loadBinary(const std::string &path, BinaryFormat format,
+                                  ThreadPool *pool) {
+  auto start = std::chrono::steady_clock::now();
+  map(path);
+
+  const size_t point_bytes =
+      (format == BinaryFormat::Float2) ? sizeof(float2) : 2 * sizeof(double);
+  if (m_map_size % point_bytes != 0) {
+    unmap();
+    throw std::runtime_error("PointLoader: truncated binary file " + path);
+  }
+
+  PointSpan span;
+  span.size = m_map_size / point_bytes;
+  if (format == BinaryFormat::Float2) {
+    // the mapping is the point array
+    m_points.clear();
+    span.data = reinterpret_cast<const float2 *>(m_map);
+  } else {
+    const double *values = reinterpret_cast<const double *>(m_map);
+    m_points.resize(span.size);
+    ThreadPool::forRange(
+        pool, span.size, 1 << 16, [this, values](size_t b, size_t e) {
+          for (size_t i = b; i < e; i++) {
+            m_points[i] =
+                float2(float(values[2 * i]), float(values[2 * i + 1]));
+          }
+        });
+    span.data = m_points.data();
+  }
+
+  m_stats.bytes = m_map_size;
+  m_stats.num_points = span.size;
+  m_stats.seconds = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+  return span;
+}
+
+PointSpan PointLoader::loadText(const std::string &path, ThreadPool *pool) {
+  auto start = std::chrono::steady_clock::now();
+  map(path);
+  const char *text = m_map;
+  const size_t size = m_map_size;
+
+  // chunks start right after a newline
+  size_t num_chunks = 1;
+  if (pool && size >= kMinParallelBytes) {
+    num_chunks = pool->numThreads() * kChunksPerThread;
+  }
+  m_chunk_begin.assign(num_chunks + 1, size);
+  m_chunk_begin[0] = 0;
+  for (size_t c = 1; c < num_chunks; c++) {
+    size_t pos = std::max(size * c / num_chunks, m_chunk_begin[c - 1]);
+    const void *nl = pos < size ? std::memchr(text + pos, '\n', size - pos)
+                                : nullptr;
+    m_chunk_begin[c] = nl ? static_cast<const char *>(nl) - text + 1 : size;
+  }
+
+  // 1. lines per chunk bound the points: chunk output offsets
+  m_chunk_count.assign(num_chunks + 1, 0);
+  ThreadPool::forRange(pool, num_chunks, 1, [this, text](size_t b, size_t e) {
+    for (size_t c = b; c < e; c++) {
+      m_chunk_count[c + 1] =
+          countLines(text + m_chunk_begin[c], text + m_chunk_begin[c + 1]);
+    }
+  });
+  for (size_t c = 0; c < num_chunks; c++) {
+    m_chunk_count[c + 1] += m_chunk_count[c];
+  }
+  m_points.resize(m_chunk_count[num_chunks]);
+
+  // 2. parse each chunk at its offset, keep number of points found
+  std::vector<size_t> parsed(num_chunks, 0);
+  ThreadPool::forRange(
+      pool, num_chunks, 1, [this, text, &parsed](size_t b, size_t e) {
+        for (size_t c = b; c < e; c++) {
+          float2 *out = m_points.data() + m_chunk_count[c];
+          const char *s = text + m_chunk_begin[c];
+          const char *end = text + m_chunk_begin[c + 1];
+          size_t count = 0;
+          while (s < end) {
+            const char *nl =
+                static_cast<const char *>(std::memchr(s, '\n', end - s));
+            const char *line_end = nl ? nl : end;
+            if (parseLine(s, line_end, out[count])) {
+              count++;
+            }
+            s = line_end + 1;
+          }
+          parsed[c] = count;
+        }
+      });
+
+  // 3. close gaps left by skipped lines (moves only go backward)
+  size_t total = 0;
+  for (size_t c = 0; c < num_chunks; c++) {
+    if (total != m_chunk_count[c]) {
+      std::memmove(m_points.data() + total, m_points.data() + m_chunk_count[c],
+                   parsed[c] * sizeof(float2));
+    }
+    total += parsed[c];
+  }
+  m_points.resize(total);
+
+  PointSpan span;
+  span.data = m_points.data();
+  span.size = total;
+  m_stats.bytes = size;
+  m_stats.num_points = total;
+  m_stats.seconds = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+  return span;
+}
+
+PointSpan PointLoader::load(const std::string &path, ThreadPool *pool) {
+  auto endsWith = [&path](const char *suffix) {
+    size_t n = std::strlen(suffix);
+    return path.size() >= n && path.compare(path.size() - n, n, suffix) == 0;
+  };
+  if (endsWith(".f32") || endsWith(".bin")) {
+    return loadBinary(path, BinaryFormat::Float2, pool);
+  }
+  if (endsWith(".f64")) {
+    return loadBinary(path, BinaryFormat::Double2, pool);
+  }
+  return loadText(path, pool);
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "delaunay.h"
+#include "thread_pool.h"
+
+// layout of a packed binary point file (no header, native endianness)
+enum class BinaryFormat {
+  Float2, // float x, float y
+  Double2 // double x, double y
+};
+
+// points returned by a PointLoader
+struct PointSpan {
+  const float2 *data = nullptr;
+  size_t size = 0;
+};
+
+// throughput of last load
+struct LoadStats {
+  size_t bytes = 0;
+  size_t num_points = 0;
+  double seconds = 0;
+
+  double megabytesPerSecond() const {
+    return seconds > 0 ? double(bytes) / (1024.0 * 1024.0) / seconds : 0.0;
+  }
+};
+
+/*!
+ * \brief Loads points from files
+ *
+ * Files are memory mapped. Packed float2 files are used in place, without
+ * any copy; double2 files are converted in parallel. Text files (csv or
+ * whitespace separated, one point per line, x and y being the first two
+ * fields) are split in chunks on newline boundaries and parsed in parallel;
+ * lines not starting with two numbers (headers, comments) are skipped.
+ * Returned points stay valid until the next load or destruction.
+ */
+class PointLoader {
+public:
+  PointLoader() = default;
+  ~PointLoader();
+
+  PointLoader(const PointLoader &) = delete;
+  PointLoader &operator=(const PointLoader &) = delete;
+
+  /*!
+   * \brief Loads a packed binary file
+   * \param path file name
+   * \param format layout of the file
+   * \param pool optional pool converting double2 files (may be null)
+   * throws std::runtime_error if the file cannot be mapped or is truncated
+   */
+  PointSpan loadBinary(const std::string &path, BinaryFormat format,
+                       ThreadPool *pool = nullptr);
+
+  /*!
+   * \brief Loads a csv / whitespace separated text file
+   * \param path file name
+   * \param pool optional pool parsing chunks in parallel (may be null)
+   * throws std::runtime_error if the file cannot be mapped
+   */
+  PointSpan loadText(const std::string &path, ThreadPool *pool = nullptr);
+
+  /*!
+   * \brief Loads a file, format given by its extension
+   * \param path .f32 or .bin: Float2, .f64: Double2, anything else: text
+   * \param pool optional pool (may be null)
+   */
+  PointSpan load(const std::string &path, ThreadPool *pool = nullptr);
+
+  const LoadStats &stats() const { return m_stats; }
+
+private:
+  // maps whole file, previous mapping is released
+  void map(const std::string &path);
+  void unmap();
+
+private:
+  const char *m_map = nullptr;
+  size_t m_map_size = 0;
+  std::vector<float2> m_points;      // converted or parsed points
+  std::vector<size_t> m_chunk_begin; // text chunks, size num_chunks + 1
+  std::vector<size_t> m_chunk_count; // points parsed per chunk
+  LoadStats m_stats;
+};
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*!
+ * \brief Triangulation compacted into contiguous index arrays
+ *
+ * Vertex ids are the ones of DivideConquer::orderedPoints(). Neighbours of
+ * vertex v are neighbours[offsets[v] .. offsets[v + 1]), in counterclockwise
+ * order, and lenghts (squared) are parallel to neighbours: every edge is
+ * stored twice, once per end point.
+ */
+struct TriangulationMesh {
+  std::vector<uint32_t> offsets;    // size numVertices() + 1
+  std::vector<uint32_t> neighbours; // adjacent vertex ids
+  std::vector<float> lenghts;       // lenght squared of each adjacency
+  std::vector<uint32_t> triangles;  // 3 vertex ids per ccw triangle
+  std::vector<uint32_t> hull;       // ccw convex hull, from leftmost vertex
+
+  size_t numVertices() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+  // number of (undirected) edges
+  size_t numEdges() const { return neighbours.size() / 2; }
+  size_t numTriangles() const { return triangles.size() / 3; }
+  uint32_t degree(uint32_t v) const { return offsets[v + 1] - offsets[v]; }
+};
@@ -0,0 +1,105 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+/*!
+ * \brief Blocking queue of bounded capacity between two pipeline stages
+ *
+ * push waits while the queue is full and pop while it is empty: a stage
+ * faster than the next one stalls instead of piling up work, so a pipeline
+ * runs at the pace of its slowest stage. Once closed, push refuses values
+ * and pop drains the remaining ones, then both return false: stages exit
+ * their loop.
+ */
+template <typename T> class BoundedQueue {
+public:
+  explicit BoundedQueue(size_t capacity) : m_capacity(capacity) {}
+
+  BoundedQueue(const BoundedQueue &) = delete;
+  BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+  // false if the queue was closed (value is left untouched)
+  bool push(T &value) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_not_full.wait(lock, [this] {
+      return m_closed || m_values.size() < m_capacity;
+    });
+    if (m_closed) {
+      return false;
+    }
+    m_values.push_back(std::move(value));
+    m_not_empty.notify_one();
+    return true;
+  }
+
+  // false once the queue is closed and empty
+  bool pop(T &value) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_not_empty.wait(lock, [this] { return m_closed || !m_values.empty(); });
+    if (m_values.empty()) {
+      return false;
+    }
+    value = std::move(m_values.front());
+    m_values.pop_front();
+    m_not_full.notify_one();
+    return true;
+  }
+
+  // wakes up all waiting stages
+  void close() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_closed = true;
+    m_not_full.notify_all();
+    m_not_empty.notify_all();
+  }
+
+private:
+  size_t m_capacity;
+  bool m_closed = false;
+  std::deque<T> m_values;
+  std::mutex m_mutex;
+  std::condition_variable m_not_full;
+  std::condition_variable m_not_empty;
+};
+
+/*!
+ * \brief Latest value published by a producer, taken by a consumer
+ *
+ * Never blocks: a value published before the previous one was taken
+ * replaces it, and the replaced value is handed back to the producer (to be
+ * recycled). The consumer only ever sees the most recent value.
+ */
+template <typename T> class LatestValue {
+public:
+  LatestValue() = default;
+
+  LatestValue(const LatestValue &) = delete;
+  LatestValue &operator=(const LatestValue &) = delete;
+
+  // stores value, value gets the replaced one (empty T if it was taken)
+  void publish(T &value) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::swap(m_value, value);
+    m_fresh = true;
+  }
+
+  // moves the latest value out, false if none since last take
+  bool take(T &value) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_fresh) {
+      return false;
+    }
+    value = std::move(m_value);
+    m_value = T();
+    m_fresh = false;
+    return true;
+  }
+
+private:
+  T m_value = T();
+  bool m_fresh = false;
+  std::mutex m_mutex;
+};
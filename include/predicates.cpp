@@ -0,0 +1,412 @@
+#include "predicates.h"
+
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+/*********************** Error bounds *************************/
+// kCcwErrBound and kIccErrBound are in predicates.h
+const double kSplitter = 134217729.0; // 2^27 + 1
+
+/*********************** Counters *****************************/
+#ifdef DELAUNAY_STATS
+// one block per thread: increments never contend between threads
+struct CounterBlock {
+  std::atomic<uint64_t> orient_filtered{0};
+  std::atomic<uint64_t> orient_exact{0};
+  std::atomic<uint64_t> incircle_filtered{0};
+  std::atomic<uint64_t> incircle_exact{0};
+};
+
+std::mutex g_blocks_mutex;
+std::vector<std::unique_ptr<CounterBlock>> g_blocks; // never shrinks
+
+CounterBlock &localCounters() {
+  thread_local CounterBlock *block = nullptr;
+  if (!block) {
+    std::lock_guard<std::mutex> lock(g_blocks_mutex);
+    g_blocks.emplace_back(new CounterBlock());
+    block = g_blocks.back().get();
+  }
+  return *block;
+}
+
+inline void count(std::atomic<uint64_t> CounterBlock::*counter) {
+  std::atomic<uint64_t> &c = localCounters().*counter;
+  c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+#define COUNT(counter) count(&CounterBlock::counter)
+#else
+#define COUNT(counter)
+#endif
+
+/*********************** Expansion arithmetic *****************/
+// Expansions are arrays of non-overlapping doubles sorted by increasing
+// magnitude, their exact sum being the represented value.
+
+inline void fastTwoSum(double a, double b, double &x, double &y) {
+  x = a + b;
+  double bvirt = x - a;
+  y = b - bvirt;
+}
+
+inline void twoSum(double a, double b, double &x, double &y) {
+  x = a + b;
+  double bvirt = x - a;
+  double avirt = x - bvirt;
+  double bround = b - bvirt;
+  double around = a - avirt;
+  y = around + bround;
+}
+
+inline void twoDiff(double a, double b, double &x, double &y) {
+  x = a - b;
+  double bvirt = a - x;
+  double avirt = x + bvirt;
+  double bround = bvirt - b;
+  double around = a - avirt;
+  y = around + bround;
+}
+
+inline void split(double a, double &hi, double &lo) {
+  double c = kSplitter * a;
+  double abig = c - a;
+  hi = c - abig;
+  lo = a - hi;
+}
+
+inline void twoProduct(double a, double b, double &x, double &y) {
+  x = a * b;
+  double ahi, alo, bhi, blo;
+  split(a, ahi, alo);
+  split(b, bhi, blo);
+  double err1 = x - (ahi * bhi);
+  double err2 = err1 - (alo * bhi);
+  double err3 = err2 - (ahi * blo);
+  y = (alo * blo) - err3;
+}
+
+// h = e + f, zero components removed; returns length of h
+int expansionSum(int elen, const double *e, int flen, const double *f,
+                 double *h) {
+  int ei = 0;
+  int fi = 0;
+  int hi = 0;
+  double Q;
+  double Qnew;
+  double hh;
+
+  // always consume the smallest remaining component first
+  auto takeE = [&]() {
+    return fi == flen ||
+           (ei < elen && ((f[fi] > e[ei]) == (f[fi] > -e[ei])));
+  };
+
+  if (takeE()) {
+    Q = e[ei++];
+  } else {
+    Q = f[fi++];
+  }
+  while (ei < elen || fi < flen) {
+    double next = takeE() ? e[ei++] : f[fi++];
+    twoSum(Q, next, Qnew, hh);
+    Q = Qnew;
+    if (hh != 0.0) {
+      h[hi++] = hh;
+    }
+  }
+  if (Q != 0.0 || hi == 0) {
+    h[hi++] = Q;
+  }
+  return hi;
+}
+
+// h = e * b, zero components removed; returns length of h
+int scaleExpansion(int elen, const double *e, double b, double *h) {
+  int hi = 0;
+  double Q;
+  double hh;
+  twoProduct(e[0], b, Q, hh);
+  if (hh != 0.0) {
+    h[hi++] = hh;
+  }
+  for (int i = 1; i < elen; i++) {
+    double product1;
+    double product0;
+    double sum;
+    twoProduct(e[i], b, product1, product0);
+    twoSum(Q, product0, sum, hh);
+    if (hh != 0.0) {
+      h[hi++] = hh;
+    }
+    fastTwoSum(product1, sum, Q, hh);
+    if (hh != 0.0) {
+      h[hi++] = hh;
+    }
+  }
+  if (Q != 0.0 || hi == 0) {
+    h[hi++] = Q;
+  }
+  return hi;
+}
+
+// maximum length of expansions handled by the exact in-circle
+const int kMaxExpansion = 1536;
+
+// h = e * f (h needs 2 * elen * flen entries); returns length of h
+int multiplyExpansion(int elen, const double *e, int flen, const double *f,
+                      double *h) {
+  double scaled[kMaxExpansion];
+  double acc[kMaxExpansion];
+  int len = scaleExpansion(elen, e, f[0], h);
+  for (int i = 1; i < flen; i++) {
+    int slen = scaleExpansion(elen, e, f[i], scaled);
+    for (int k = 0; k < len; k++) {
+      acc[k] = h[k];
+    }
+    len = expansionSum(len, acc, slen, scaled, h);
+  }
+  return len;
+}
+
+// exact a * d - b * c for doubles
+int crossExpansion(double a, double d, double b, double c, double *h) {
+  double ad[2];
+  double bc[2];
+  twoProduct(a, d, ad[1], ad[0]);
+  twoProduct(b, c, bc[1], bc[0]);
+  bc[0] = -bc[0];
+  bc[1] = -bc[1];
+  return expansionSum(2, ad, 2, bc, h);
+}
+
+double orient2dExact(double ax, double ay, double bx, double by, double cx,
+                     double cy) {
+  // ax*by - ay*bx + bx*cy - by*cx + cx*ay - cy*ax, each product being exact
+  double ab[4];
+  double bc[4];
+  double ca[4];
+  double abbc[8];
+  double det[12];
+  int ablen = crossExpansion(ax, by, ay, bx, ab);
+  int bclen = crossExpansion(bx, cy, by, cx, bc);
+  int calen = crossExpansion(cx, ay, cy, ax, ca);
+  int abbclen = expansionSum(ablen, ab, bclen, bc, abbc);
+  int len = expansionSum(abbclen, abbc, calen, ca, det);
+  return det[len - 1];
+}
+
+// exact lifted coordinate dx^2 + dy^2 of 2-component differences
+int liftExpansion(const double *dx, const double *dy, double *h) {
+  double x2[8];
+  double y2[8];
+  int x2len = multiplyExpansion(2, dx, 2, dx, x2);
+  int y2len = multiplyExpansion(2, dy, 2, dy, y2);
+  return expansionSum(x2len, x2, y2len, y2, h);
+}
+
+// exact ux * vy - vx * uy of 2-component differences
+int crossDiffExpansion(const double *ux, const double *uy, const double *vx,
+                       const double *vy, double *h) {
+  double p[8];
+  double q[8];
+  int plen = multiplyExpansion(2, ux, 2, vy, p);
+  int qlen = multiplyExpansion(2, vx, 2, uy, q);
+  for (int i = 0; i < qlen; i++) {
+    q[i] = -q[i];
+  }
+  return expansionSum(plen, p, qlen, q, h);
+}
+
+double incircleExact(double ax, double ay, double bx, double by, double cx,
+                     double cy, double dx, double dy) {
+  // differences are exact as 2-component expansions
+  double adx[2], ady[2], bdx[2], bdy[2], cdx[2], cdy[2];
+  twoDiff(ax, dx, adx[1], adx[0]);
+  twoDiff(ay, dy, ady[1], ady[0]);
+  twoDiff(bx, dx, bdx[1], bdx[0]);
+  twoDiff(by, dy, bdy[1], bdy[0]);
+  twoDiff(cx, dx, cdx[1], cdx[0]);
+  twoDiff(cy, dy, cdy[1], cdy[0]);
+
+  double lift[16];
+  double cross[16];
+  double aterm[512];
+  double bterm[512];
+  double cterm[512];
+  double abterm[1024];
+  double det[kMaxExpansion];
+
+  int liftlen = liftExpansion(adx, ady, lift);
+  int crosslen = crossDiffExpansion(bdx, bdy, cdx, cdy, cross);
+  int alen = multiplyExpansion(liftlen, lift, crosslen, cross, aterm);
+
+  liftlen = liftExpansion(bdx, bdy, lift);
+  crosslen = crossDiffExpansion(cdx, cdy, adx, ady, cross);
+  int blen = multiplyExpansion(liftlen, lift, crosslen, cross, bterm);
+
+  liftlen = liftExpansion(cdx, cdy, lift);
+  crosslen = crossDiffExpansion(adx, ady, bdx, bdy, cross);
+  int clen = multiplyExpansion(liftlen, lift, crosslen, cross, cterm);
+
+  int ablen = expansionSum(alen, aterm, blen, bterm, abterm);
+  int len = expansionSum(ablen, abterm, clen, cterm, det);
+  return det[len - 1];
+}
+
+} // namespace
+
+/*********************** Predicates ***************************/
+
+double orient2d(double ax, double ay, double bx, double by, double cx,
+                double cy) {
+  double detleft = (ax - cx) * (by - cy);
+  double detright = (ay - cy) * (bx - cx);
+  double det = detleft - detright;
+
+  double errbound = kCcwErrBound * (std::fabs(detleft) + std::fabs(detright));
+  if (det > errbound || -det > errbound) {
+    COUNT(orient_filtered);
+    return det;
+  }
+  COUNT(orient_exact);
+  return orient2dExact(ax, ay, bx, by, cx, cy);
+}
+
+double incircle(double ax, double ay, double bx, double by, double cx,
+                double cy, double dx, double dy) {
+  double adx = ax - dx;
+  double bdx = bx - dx;
+  double cdx = cx - dx;
+  double ady = ay - dy;
+  double bdy = by - dy;
+  double cdy = cy - dy;
+
+  double bdxcdy = bdx * cdy;
+  double cdxbdy = cdx * bdy;
+  double alift = adx * adx + ady * ady;
+
+  double cdxady = cdx * ady;
+  double adxcdy = adx * cdy;
+  double blift = bdx * bdx + bdy * bdy;
+
+  double adxbdy = adx * bdy;
+  double bdxady = bdx * ady;
+  double clift = cdx * cdx + cdy * cdy;
+
+  double det = alift * (bdxcdy - cdxbdy) + blift * (cdxady - adxcdy) +
+               clift * (adxbdy - bdxady);
+
+  double permanent = (std::fabs(bdxcdy) + std::fabs(cdxbdy)) * alift +
+                     (std::fabs(cdxady) + std::fabs(adxcdy)) * blift +
+                     (std::fabs(adxbdy) + std::fabs(bdxady)) * clift;
+  double errbound = kIccErrBound * permanent;
+  if (det > errbound || -det > errbound) {
+    COUNT(incircle_filtered);
+    return det;
+  }
+  COUNT(incircle_exact);
+  return incircleExact(ax, ay, bx, by, cx, cy, dx, dy);
+}
+
+/*********************** Integer predicates *******************/
+
+#ifdef __SIZEOF_INT128__
+namespace {
+
+inline int sign(__int128 v) { return (v > 0) - (v < 0); }
+
+// differences of int32 need 33 bits, their products 66 bits
+inline __int128 cross(int64_t ux, int64_t uy, int64_t vx, int64_t vy) {
+  return static_cast<__int128>(ux) * vy - static_cast<__int128>(uy) * vx;
+}
+
+// bound on differences keeping the incircle determinant in 128 bits:
+// lifts and crosses below 2^61, their products below 2^122
+const int64_t kIncircleMaxDiff = int64_t(1) << 30;
+
+inline bool smallDiff(int64_t d) {
+  return d < kIncircleMaxDiff && -d < kIncircleMaxDiff;
+}
+
+} // namespace
+
+int orient2dInt(int32_t ax, int32_t ay, int32_t bx, int32_t by, int32_t cx,
+                int32_t cy) {
+  COUNT(orient_filtered);
+  return sign(cross(int64_t(ax) - cx, int64_t(ay) - cy, int64_t(bx) - cx,
+                    int64_t(by) - cy));
+}
+
+int incircleInt(int32_t ax, int32_t ay, int32_t bx, int32_t by, int32_t cx,
+                int32_t cy, int32_t dx, int32_t dy) {
+  int64_t adx = int64_t(ax) - dx;
+  int64_t bdx = int64_t(bx) - dx;
+  int64_t cdx = int64_t(cx) - dx;
+  int64_t ady = int64_t(ay) - dy;
+  int64_t bdy = int64_t(by) - dy;
+  int64_t cdy = int64_t(cy) - dy;
+  if (!smallDiff(adx) || !smallDiff(bdx) || !smallDiff(cdx) ||
+      !smallDiff(ady) || !smallDiff(bdy) || !smallDiff(cdy)) {
+    double det = incircle(double(ax), double(ay), double(bx), double(by),
+                          double(cx), double(cy), double(dx), double(dy));
+    return (det > 0) - (det < 0);
+  }
+  COUNT(incircle_filtered);
+  // below 2^30, squares and products fit 64 bits
+  __int128 alift = adx * adx + ady * ady;
+  __int128 blift = bdx * bdx + bdy * bdy;
+  __int128 clift = cdx * cdx + cdy * cdy;
+  __int128 det = alift * (bdx * cdy - cdx * bdy) +
+                 blift * (cdx * ady - adx * cdy) +
+                 clift * (adx * bdy - bdx * ady);
+  return sign(det);
+}
+#else
+// int32 coordinates are exact doubles: the double predicates are exact too
+int orient2dInt(int32_t ax, int32_t ay, int32_t bx, int32_t by, int32_t cx,
+                int32_t cy) {
+  double det = orient2d(double(ax), double(ay), double(bx), double(by),
+                        double(cx), double(cy));
+  return (det > 0) - (det < 0);
+}
+
+int incircleInt(int32_t ax, int32_t ay, int32_t bx, int32_t by, int32_t cx,
+                int32_t cy, int32_t dx, int32_t dy) {
+  double det = incircle(double(ax), double(ay), double(bx), double(by),
+                        double(cx), double(cy), double(dx), double(dy));
+  return (det > 0) - (det < 0);
+}
+#endif
+
+/*********************** Counters *****************************/
+
+PredicateCounters predicateCounters() {
+  PredicateCounters total;
+#ifdef DELAUNAY_STATS
+  std::lock_guard<std::mutex> lock(g_blocks_mutex);
+  for (const auto &b : g_blocks) {
+    total.orient_filtered += b->orient_filtered.load();
+    total.orient_exact += b->orient_exact.load();
+    total.incircle_filtered += b->incircle_filtered.load();
+    total.incircle_exact += b->incircle_exact.load();
+  }
+#endif
+  return total;
+}
+
+void resetPredicateCounters() {
+#ifdef DELAUNAY_STATS
+  std::lock_guard<std::mutex> lock(g_blocks_mutex);
+  for (const auto &b : g_blocks) {
+    b->orient_filtered = 0;
+    b->orient_exact = 0;
+    b->incircle_filtered = 0;
+    b->incircle_exact = 0;
+  }
+#endif
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+
+/*!
+ * \brief Robust geometric predicates
+ *
+ * Each predicate first evaluates its determinant in double precision and
+ * compares it with a semi-static error bound (Shewchuk's bounds scaled by the
+ * magnitude of the terms actually computed). Only when the sign cannot be
+ * trusted, the determinant is evaluated again with exact floating-point
+ * expansion arithmetic. The returned value always has the exact sign.
+ */
+
+// Error bounds of the filters (Shewchuk, "Adaptive Precision Floating-Point
+// Arithmetic and Fast Robust Geometric Predicates", 1997): a determinant
+// whose magnitude exceeds bound * permanent has the sign of its double
+// evaluation. Also used by callers filtering many determinants at once.
+const double kPredicateEpsilon = 1.1102230246251565e-16; // 2^-53
+const double kCcwErrBound =
+    (3.0 + 16.0 * kPredicateEpsilon) * kPredicateEpsilon;
+const double kIccErrBound =
+    (10.0 + 96.0 * kPredicateEpsilon) * kPredicateEpsilon;
+
+/*!
+ * \brief Orientation of a triangle
+ * \return > 0 if (a, b, c) are counterclockwise, < 0 if clockwise and 0 if
+ * they are collinear
+ */
+double orient2d(double ax, double ay, double bx, double by, double cx,
+                double cy);
+
+/*!
+ * \brief In-circle test
+ * \return > 0 if d lies inside the circle through counterclockwise (a, b, c),
+ * < 0 if it lies outside and 0 if the four points are cocircular
+ */
+double incircle(double ax, double ay, double bx, double by, double cx,
+                double cy, double dx, double dy);
+
+/*!
+ * \brief Orientation of a triangle of integer points
+ * Exact integer arithmetic, no filter (128 bits products when the compiler
+ * has them, double predicate otherwise).
+ * \return 1 if (a, b, c) are counterclockwise, -1 if clockwise and 0 if
+ * they are collinear
+ */
+int orient2dInt(int32_t ax, int32_t ay, int32_t bx, int32_t by, int32_t cx,
+                int32_t cy);
+
+/*!
+ * \brief In-circle test of integer points
+ * Exact integer arithmetic while coordinate differences stay below 2^30
+ * (determinant fits 128 bits), double predicate beyond.
+ * \return 1 if d lies inside the circle through counterclockwise (a, b, c),
+ * -1 if it lies outside and 0 if the four points are cocircular
+ */
+int incircleInt(int32_t ax, int32_t ay, int32_t bx, int32_t by, int32_t cx,
+                int32_t cy, int32_t dx, int32_t dy);
+
+/*!
+ * \brief Number of times each evaluation path was taken
+ * Integer predicates decided without the double fallback count as filtered.
+ * Counters are only maintained when compiled with DELAUNAY_STATS.
+ */
+struct PredicateCounters {
+  uint64_t orient_filtered = 0;   // orient2d decided by the fast filter
+  uint64_t orient_exact = 0;      // orient2d needing exact arithmetic
+  uint64_t incircle_filtered = 0; // incircle decided by the fast filter
+  uint64_t incircle_exact = 0;    // incircle needing exact arithmetic
+};
+
+// sum of counters of all threads since last reset
+PredicateCounters predicateCounters();
+// sets counters of all threads to zero
+void resetPredicateCounters();
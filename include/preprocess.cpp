@@ -0,0 +1,295 @@
+#include "preprocess.h"
+#include "delaunay.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
+
+const int kDigitBits = 11;
+const uint32_t kBuckets = 1u << kDigitBits;
+const int kNumPasses = (64 + kDigitBits - 1) / kDigitBits;
+// below this, a single chunk is faster than spreading work
+const size_t kMinParallelPoints = 1 << 16;
+
+// monotonic mapping float -> uint32: a < b <=> key(a) < key(b)
+inline uint32_t floatKey(float f) {
+  if (f == 0.0f) {
+    f = 0.0f; // -0 and +0 are the same coordinate
+  }
+  uint32_t u;
+  std::memcpy(&u, &f, sizeof(u));
+  return (u & 0x80000000u) ? ~u : (u | 0x80000000u);
+}
+
+// inverse of floatKey
+inline float keyFloat(uint32_t k) {
+  uint32_t u = (k & 0x80000000u) ? (k & 0x7fffffffu) : ~k;
+  float f;
+  std::memcpy(&f, &u, sizeof(f));
+  return f;
+}
+
+/*!
+ * \brief Sort key of a coordinate type
+ * exact: equal keys are equal coordinates, key decodes back to them.
+ * Otherwise keys only order coordinates (a < b => key(a) <= key(b)).
+ */
+template <typename T> struct CoordKey;
+
+template <> struct CoordKey<float> {
+  static const bool exact = true;
+  static uint32_t key(float v, float cell) {
+    return floatKey(snapCoordinate(v, cell));
+  }
+  static float value(uint32_t k) { return keyFloat(k); }
+};
+
+template <> struct CoordKey<int32_t> {
+  static const bool exact = true;
+  static uint32_t key(int32_t v, float) { return uint32_t(v) ^ 0x80000000u; }
+  static int32_t value(uint32_t k) { return int32_t(k ^ 0x80000000u); }
+};
+
+template <> struct CoordKey<double> {
+  static const bool exact = false;
+  static uint32_t key(double v, float cell) {
+    return floatKey(static_cast<float>(snapCoordinate(v, cell)));
+  }
+  static double value(uint32_t k) { return keyFloat(k); }
+};
+
+} // namespace
+
+template <typename F>
+void PointPreprocessor::forChunks(ThreadPool *pool, size_t num_chunks, size_t n,
+                                  F body) {
+  if (num_chunks == 1) {
+    body(0, 0, n);
+    return;
+  }
+  ThreadPool::TaskGroup group(*pool);
+  for (size_t c = 0; c < num_chunks; c++) {
+    size_t begin = n * c / num_chunks;
+    size_t end = n * (c + 1) / num_chunks;
+    group.run([&body, c, begin, end] { body(c, begin, end); });
+  }
+  group.wait();
+}
+
+template <typename T>
+void PointPreprocessor::run(const Vec2<T> *points, size_t num_points,
+                            const DedupPolicy &policy, ThreadPool *pool,
+                            std::vector<Vec2<T>> &ordered,
+                            std::vector<int> &input_to_vertex) {
+  auto start = std::chrono::steady_clock::now();
+  buildKeys(points, num_points, policy, pool);
+  radixSort(pool);
+  if (!CoordKey<T>::exact) {
+    refineRuns(points, policy);
+  }
+  auto sorted = std::chrono::steady_clock::now();
+  dedup(points, policy, pool, ordered, input_to_vertex);
+  m_sort_seconds = std::chrono::duration<double>(sorted - start).count();
+  m_dedup_seconds = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - sorted)
+                        .count();
+}
+
+template <typename T>
+void PointPreprocessor::buildKeys(const Vec2<T> *points, size_t num_points,
+                                  const DedupPolicy &policy, ThreadPool *pool) {
+  m_keys.resize(num_points);
+  m_perm.resize(num_points);
+  m_keys_tmp.resize(num_points);
+  m_perm_tmp.resize(num_points);
+
+  const float cell = policy.snap_cell;
+  size_t num_chunks =
+      (pool && num_points >= kMinParallelPoints) ? pool->numThreads() : 1;
+  forChunks(pool, num_chunks, num_points,
+            [this, points, cell](size_t, size_t begin, size_t end) {
+              for (size_t i = begin; i < end; i++) {
+                uint64_t kx = CoordKey<T>::key(points[i].x, cell);
+                uint64_t ky = CoordKey<T>::key(points[i].y, cell);
+                m_keys[i] = (kx << 32) | ky;
+                m_perm[i] = static_cast<uint32_t>(i);
+              }
+            });
+}
+
+void PointPreprocessor::radixSort(ThreadPool *pool) {
+  const size_t n = m_keys.size();
+  const size_t num_chunks =
+      (pool && n >= kMinParallelPoints) ? pool->numThreads() : 1;
+  m_histograms.resize(num_chunks * kBuckets);
+
+  for (int pass = 0; pass < kNumPasses; pass++) {
+    const int shift = pass * kDigitBits;
+
+    // 1. histogram of the digit for each chunk
+    forChunks(pool, num_chunks, n,
+              [this, shift](size_t c, size_t begin, size_t end) {
+                uint32_t *hist = &m_histograms[c * kBuckets];
+                std::fill(hist, hist + kBuckets, 0);
+                for (size_t i = begin; i < end; i++) {
+                  hist[(m_keys[i] >> shift) & (kBuckets - 1)]++;
+                }
+              });
+
+    // 2. exclusive prefix sum, bucket major then chunk: keeps sort stable.
+    // A digit shared by all keys leaves the order unchanged: skip the pass.
+    bool skip = false;
+    uint32_t offset = 0;
+    for (uint32_t b = 0; b < kBuckets; b++) {
+      const uint32_t bucket_begin = offset;
+      for (size_t c = 0; c < num_chunks; c++) {
+        uint32_t &h = m_histograms[c * kBuckets + b];
+        uint32_t count = h;
+        h = offset;
+        offset += count;
+      }
+      if (offset - bucket_begin == n) {
+        skip = true;
+      }
+    }
+    if (skip) {
+      continue;
+    }
+
+    // 3. scatter
+    forChunks(pool, num_chunks, n,
+              [this, shift](size_t c, size_t begin, size_t end) {
+                uint32_t *pos = &m_histograms[c * kBuckets];
+                for (size_t i = begin; i < end; i++) {
+                  uint32_t dst = pos[(m_keys[i] >> shift) & (kBuckets - 1)]++;
+                  m_keys_tmp[dst] = m_keys[i];
+                  m_perm_tmp[dst] = m_perm[i];
+                }
+              });
+    m_keys.swap(m_keys_tmp);
+    m_perm.swap(m_perm_tmp);
+  }
+}
+
+template <typename T>
+void PointPreprocessor::refineRuns(const Vec2<T> *points,
+                                   const DedupPolicy &policy) {
+  const float cell = policy.snap_cell;
+  // x then y, input order for equal points (as the stable radix sort)
+  auto less = [points, cell](uint32_t a, uint32_t b) {
+    T ax = snapCoordinate(points[a].x, cell);
+    T bx = snapCoordinate(points[b].x, cell);
+    if (ax != bx) {
+      return ax < bx;
+    }
+    T ay = snapCoordinate(points[a].y, cell);
+    T by = snapCoordinate(points[b].y, cell);
+    return ay < by || (ay == by && a < b);
+  };
+  // distinct x may round to the same key while their y keys differ: runs
+  // are the ones of equal x keys, not of equal keys
+  const size_t n = m_keys.size();
+  for (size_t begin = 0; begin < n;) {
+    const uint32_t kx = uint32_t(m_keys[begin] >> 32);
+    size_t end = begin + 1;
+    while (end < n && uint32_t(m_keys[end] >> 32) == kx) {
+      end++;
+    }
+    if (end - begin > 1) {
+      std::sort(m_perm.begin() + begin, m_perm.begin() + end, less);
+      // keys follow their points: dedup compares neighbours
+      for (size_t i = begin; i < end; i++) {
+        const Vec2<T> &p = points[m_perm[i]];
+        m_keys[i] = (uint64_t(kx) << 32) | CoordKey<T>::key(p.y, cell);
+      }
+    }
+    begin = end;
+  }
+}
+
+template <typename T>
+void PointPreprocessor::dedup(const Vec2<T> *points, const DedupPolicy &policy,
+                              ThreadPool *pool, std::vector<Vec2<T>> &ordered,
+                              std::vector<int> &input_to_vertex) {
+  const size_t n = m_keys.size();
+  input_to_vertex.resize(n);
+  if (n == 0) {
+    ordered.clear();
+    return;
+  }
+  const size_t num_chunks =
+      (pool && n >= kMinParallelPoints) ? pool->numThreads() : 1;
+  m_chunk_unique.assign(num_chunks + 1, 0);
+
+  // first key of a run of equal keys starts a new vertex (first point of a
+  // run of equal points when keys are not exact)
+  const float cell = policy.snap_cell;
+  auto snapped = [points, cell](uint32_t i) {
+    return Vec2<T>(snapCoordinate(points[i].x, cell),
+                   snapCoordinate(points[i].y, cell));
+  };
+  auto isNew = [this, &snapped](size_t i) {
+    if (i == 0 || m_keys[i] != m_keys[i - 1]) {
+      return true;
+    }
+    if (CoordKey<T>::exact) {
+      return false;
+    }
+    Vec2<T> a = snapped(m_perm[i - 1]);
+    Vec2<T> b = snapped(m_perm[i]);
+    return a.x != b.x || a.y != b.y;
+  };
+
+  if (num_chunks > 1) {
+    forChunks(pool, num_chunks, n,
+              [this, &isNew](size_t c, size_t begin, size_t end) {
+                size_t count = 0;
+                for (size_t i = begin; i < end; i++) {
+                  count += isNew(i);
+                }
+                m_chunk_unique[c + 1] = count;
+              });
+    for (size_t c = 0; c < num_chunks; c++) {
+      m_chunk_unique[c + 1] += m_chunk_unique[c];
+    }
+    ordered.resize(m_chunk_unique[num_chunks]);
+  } else {
+    ordered.resize(n); // shrunk once the unique count is known
+  }
+
+  // fused pass: gather unique points and map every input point
+  forChunks(pool, num_chunks, n,
+            [this, &isNew, &snapped, &ordered, &input_to_vertex,
+             num_chunks](size_t c, size_t begin, size_t end) {
+              int id = static_cast<int>(m_chunk_unique[c]) - 1;
+              for (size_t i = begin; i < end; i++) {
+                if (isNew(i)) {
+                  id++;
+                  ordered[id] =
+                      CoordKey<T>::exact
+                          ? Vec2<T>(
+                                CoordKey<T>::value(uint32_t(m_keys[i] >> 32)),
+                                CoordKey<T>::value(uint32_t(m_keys[i])))
+                          : snapped(m_perm[i]);
+                }
+                input_to_vertex[m_perm[i]] = id;
+              }
+              if (c + 1 == num_chunks) {
+                m_chunk_unique[num_chunks] = id + 1;
+              }
+            });
+  ordered.resize(m_chunk_unique[num_chunks]);
+}
+
+template void PointPreprocessor::run(const float2 *, size_t,
+                                     const DedupPolicy &, ThreadPool *,
+                                     std::vector<float2> &, std::vector<int> &);
+template void PointPreprocessor::run(const double2 *, size_t,
+                                     const DedupPolicy &, ThreadPool *,
+                                     std::vector<double2> &,
+                                     std::vector<int> &);
+template void PointPreprocessor::run(const int2 *, size_t,
+                                     const DedupPolicy &, ThreadPool *,
+                                     std::vector<int2> &, std::vector<int> &);
@@ -0,0 +1,98 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "thread_pool.h"
+
+template <typename T> struct Vec2;
+
+/*!
+ * \brief Rule deciding when two input points are the same vertex
+ *
+ * Sorting and duplicate removal both use the same key, so two points are
+ * duplicates exactly when they end up with equal (snapped) coordinates.
+ */
+struct DedupPolicy {
+  // size of grid cells points are snapped to, 0 keeps exact coordinates
+  // (then only bitwise equal points are merged, -0 being equal to +0).
+  // Ignored for integer coordinates, already on a grid.
+  float snap_cell = 0.0f;
+};
+
+// coordinate snapped to a grid of cell size (DedupPolicy::snap_cell), as
+// points are before being compared: duplicates have equal snapped values
+inline float snapCoordinate(float v, float cell) {
+  return (cell > 0.0f) ? std::round(v / cell) * cell : v;
+}
+
+inline double snapCoordinate(double v, float cell) {
+  return (cell > 0.0f) ? std::round(v / cell) * cell : v;
+}
+
+inline int32_t snapCoordinate(int32_t v, float) { return v; }
+
+/*!
+ * \brief Sorts points x-then-y and removes duplicates
+ *
+ * Points are sorted through a permutation with a (parallel) LSD radix sort on
+ * their float bit patterns, so the input is never copied. A single pass then
+ * gathers the unique points in order and records the vertex id of every
+ * input point. Buffers are kept between calls.
+ *
+ * Integer coordinates get exact 32 bits keys too. Double coordinates are
+ * keyed by their rounding to float (monotonic), then runs of equal x keys
+ * are sorted and deduplicated on the exact values.
+ */
+class PointPreprocessor {
+public:
+  /*!
+   * \brief Computes ordered unique points and input to vertex mapping
+   * \param points input points, not modified
+   * \param num_points number of input points
+   * \param policy duplicate rule
+   * \param pool optional pool to sort in parallel (may be null)
+   * \param ordered output unique points sorted x-then-y
+   * \param input_to_vertex output vertex id of each input point
+   */
+  template <typename T>
+  void run(const Vec2<T> *points, size_t num_points,
+           const DedupPolicy &policy, ThreadPool *pool,
+           std::vector<Vec2<T>> &ordered, std::vector<int> &input_to_vertex);
+
+  // wall time of the sort (keys included) of last run, in seconds
+  double sortSeconds() const { return m_sort_seconds; }
+  // wall time of the duplicates removal of last run, in seconds
+  double dedupSeconds() const { return m_dedup_seconds; }
+
+private:
+  // fills m_keys and m_perm from input points
+  template <typename T>
+  void buildKeys(const Vec2<T> *points, size_t num_points,
+                 const DedupPolicy &policy, ThreadPool *pool);
+  // sorts m_keys, m_perm moving along
+  void radixSort(ThreadPool *pool);
+  // sorts runs of equal (rounded) x keys on exact coordinates
+  template <typename T>
+  void refineRuns(const Vec2<T> *points, const DedupPolicy &policy);
+  // gathers unique points and fills mapping
+  template <typename T>
+  void dedup(const Vec2<T> *points, const DedupPolicy &policy,
+             ThreadPool *pool, std::vector<Vec2<T>> &ordered,
+             std::vector<int> &input_to_vertex);
+
+  // runs body(chunk, begin, end) on num_chunks contiguous chunks of n elements
+  template <typename F>
+  void forChunks(ThreadPool *pool, size_t num_chunks, size_t n, F body);
+
+private:
+  std::vector<uint64_t> m_keys; // x bits (high word) then y bits (low word)
+  std::vector<uint32_t> m_perm; // input index of each key
+  std::vector<uint64_t> m_keys_tmp;
+  std::vector<uint32_t> m_perm_tmp;
+  std::vector<uint32_t> m_histograms; // one histogram per chunk
+  std::vector<size_t> m_chunk_unique; // unique points per chunk
+  double m_sort_seconds = 0;
+  double m_dedup_seconds = 0;
+};
@@ -0,0 +1,227 @@
+#include "query.h"
+
+#include <cassert>
+#include <random>
+
+namespace {
+
+// fixed seed: same levels for same input
+const unsigned kSeed = 5489u;
+// levels with at most this many vertices are searched exhaustively
+const size_t kTopLevelSize = 64;
+// queries per task in batches
+const size_t kQueryGrain = 1024;
+
+inline double distanceSquared(const float2 &a, const float2 &b) {
+  double dx = double(a.x) - double(b.x);
+  double dy = double(a.y) - double(b.y);
+  return dx * dx + dy * dy;
+}
+
+// true if left face of e is a ccw triangle (not the outer face)
+inline bool isTriangle(const float2 *points, Edge *e) {
+  Edge *next = e->Lnext();
+  return next->Lnext()->Lnext() == e &&
+         ccw(points[e->Org()], points[e->Dest()], points[next->Dest()]);
+}
+
+} // namespace
+
+DelaunayHierarchy::DelaunayHierarchy(int ratio) : m_ratio(ratio) {}
+
+void DelaunayHierarchy::build(const DivideConquer &base) {
+  m_levels.clear();
+  m_upper.clear();
+
+  m_base_revision = base.revision();
+  addLevel(&base, std::vector<int>());
+
+  // each level keeps a random subsample of the level below (of its live
+  // vertices: removed ones stay in the base without edges)
+  std::mt19937 gen(kSeed);
+  std::uniform_int_distribution<int> keep(0, m_ratio - 1);
+  while (m_levels.back().dc->orderedPoints().size() > kTopLevelSize) {
+    const DivideConquer &level = *m_levels.back().dc;
+    const std::vector<float2> &finer = level.orderedPoints();
+    std::vector<float2> sample;
+    std::vector<int> to_finer;
+    for (size_t i = 0; i < finer.size(); i++) {
+      if (keep(gen) == 0 && !level.isRemoved(static_cast<int>(i))) {
+        sample.push_back(finer[i]);
+        to_finer.push_back(static_cast<int>(i));
+      }
+    }
+    if (sample.empty()) {
+      break;
+    }
+
+    // sample is unique: sample[i] is vertex inputToVertex()[i] of the new
+    // level (i itself unless the finer level was reordered)
+    std::unique_ptr<DivideConquer> dc(new DivideConquer());
+    dc->computeTriangulation(sample);
+    std::vector<int> vertex_to_finer(to_finer.size());
+    for (size_t i = 0; i < to_finer.size(); i++) {
+      vertex_to_finer[dc->inputToVertex()[i]] = to_finer[i];
+    }
+    addLevel(dc.get(), std::move(vertex_to_finer));
+    m_upper.push_back(std::move(dc));
+  }
+}
+
+void DelaunayHierarchy::addLevel(const DivideConquer *dc,
+                                 std::vector<int> to_finer) {
+  std::vector<Edge *> vertex_edge;
+  dc->vertexEdges(vertex_edge);
+
+  Level level;
+  level.dc = dc;
+  level.to_finer = std::move(to_finer);
+  level.offset.reserve(vertex_edge.size() + 1);
+  level.offset.push_back(0);
+  for (Edge *first : vertex_edge) {
+    if (first) {
+      Edge *e = first;
+      do {
+        level.neighbours.push_back(e->Dest());
+        e = e->Onext();
+      } while (e != first);
+    }
+    level.offset.push_back(level.neighbours.size());
+  }
+  if (m_levels.empty()) {
+    // the base: point location walks start from these edges
+    m_base_edges.swap(vertex_edge);
+  }
+  m_levels.push_back(std::move(level));
+}
+
+int DelaunayHierarchy::walkNearest(const Level &level, int v,
+                                   const float2 &p) const {
+  const std::vector<float2> &points = level.dc->orderedPoints();
+  double best = distanceSquared(points[v], p);
+  while (true) {
+    // in a Delaunay triangulation, a vertex that is not the nearest one
+    // always has a neighbour closer to p
+    int next = v;
+    for (size_t i = level.offset[v]; i < level.offset[v + 1]; i++) {
+      int w = level.neighbours[i];
+      double d = distanceSquared(points[w], p);
+      if (d < best) {
+        best = d;
+        next = w;
+      }
+    }
+    if (next == v) {
+      return v;
+    }
+    v = next;
+  }
+}
+
+int DelaunayHierarchy::nearestVertex(const float2 &p) const {
+  if (m_levels.empty()) {
+    return -1;
+  }
+  // edges and neighbour lists of a modified base are stale
+  assert(m_levels.front().dc->revision() == m_base_revision &&
+         "DelaunayHierarchy used after its base was modified");
+
+  // exhaustive search on the (small) top level, which is the base when it
+  // is small: removed vertices are skipped
+  const DivideConquer &top = *m_levels.back().dc;
+  const std::vector<float2> &top_points = top.orderedPoints();
+  int v = -1;
+  double best = 0;
+  for (size_t i = 0; i < top_points.size(); i++) {
+    double d = distanceSquared(top_points[i], p);
+    if ((v < 0 || d < best) && !top.isRemoved(static_cast<int>(i))) {
+      best = d;
+      v = static_cast<int>(i);
+    }
+  }
+  if (v < 0) {
+    return -1;
+  }
+
+  // then refine down to the base
+  for (size_t l = m_levels.size() - 1;; l--) {
+    v = walkNearest(m_levels[l], v, p);
+    if (l == 0) {
+      return v;
+    }
+    v = m_levels[l].to_finer[v];
+  }
+}
+
+LocateResult DelaunayHierarchy::walkLocate(int v, const float2 &p) const {
+  LocateResult result;
+  Edge *first = m_base_edges[v];
+  if (!first) {
+    return result;
+  }
+
+  // start from any triangle around v (none if all points are collinear)
+  const float2 *points = m_levels.front().dc->orderedPoints().data();
+  Edge *e = first;
+  while (!isTriangle(points, e)) {
+    e = e->Onext();
+    if (e == first) {
+      return result;
+    }
+  }
+
+  // visibility walk: cross any edge seeing p on its other side. It always
+  // terminates on a Delaunay triangulation.
+  while (true) {
+    Edge *cross = nullptr;
+    Edge *f = e;
+    for (int k = 0; k < 3; k++) {
+      if (rightOf(points, p, f)) {
+        cross = f;
+        break;
+      }
+      f = f->Lnext();
+    }
+    if (!cross) {
+      result.edge = e;
+      result.inside = true;
+      return result;
+    }
+    e = cross->Sym();
+    if (!isTriangle(points, e)) {
+      // crossed the hull
+      result.edge = cross;
+      return result;
+    }
+  }
+}
+
+LocateResult DelaunayHierarchy::locate(const float2 &p) const {
+  int v = nearestVertex(p);
+  if (v < 0) {
+    return LocateResult();
+  }
+  return walkLocate(v, p);
+}
+
+void DelaunayHierarchy::nearestVertices(const float2 *points,
+                                        size_t num_points, int *vertices,
+                                        ThreadPool *pool) const {
+  auto body = [this, points, vertices](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      vertices[i] = nearestVertex(points[i]);
+    }
+  };
+  ThreadPool::forRange(pool, num_points, kQueryGrain, body);
+}
+
+void DelaunayHierarchy::locateAll(const float2 *points, size_t num_points,
+                                  LocateResult *results,
+                                  ThreadPool *pool) const {
+  auto body = [this, points, results](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      results[i] = locate(points[i]);
+    }
+  };
+  ThreadPool::forRange(pool, num_points, kQueryGrain, body);
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "delaunay.h"
+#include "thread_pool.h"
+
+/*!
+ * \brief Result of a point location
+ *
+ * When inside, p lies in (or on the boundary of) the ccw triangle
+ * edge, edge->Lnext(), edge->Lnext()->Lnext(). Otherwise p is outside of the
+ * convex hull and edge is a hull edge seeing p on its right (null when the
+ * triangulation has no triangle at all).
+ */
+struct LocateResult {
+  Edge *edge = nullptr;
+  bool inside = false;
+};
+
+/*!
+ * \brief Nearest vertex and point location queries on a triangulation
+ *
+ * Queries descend a Delaunay hierarchy: each level triangulates a random
+ * subsample of the level below, the top level being small enough to be
+ * searched exhaustively. On each level a greedy walk moves to a neighbour
+ * closer to the query until none is, which ends on the nearest vertex of
+ * that level. Onext() rings are flattened into contiguous neighbour lists at
+ * build time, so walks do not chase edge pointers. The nearest vertex of the
+ * finest level then starts a visibility walk across triangles to locate the
+ * query.
+ *
+ * Once built, queries are const and allocate nothing: any number of threads
+ * may query concurrently. The hierarchy is a snapshot of the base: it must
+ * be built again after the base is modified (computeTriangulation, insert,
+ * remove, moveVertices, reorderVertices, releaseEdges), and queries assert
+ * that it was not. The base must outlive the hierarchy.
+ */
+class DelaunayHierarchy {
+public:
+  /*!
+   * \param ratio about one vertex in ratio is kept on the next level
+   */
+  explicit DelaunayHierarchy(int ratio = 30);
+
+  /*!
+   * \brief Builds upper levels above a computed triangulation
+   * \param base triangulation queried on the finest level (kept by pointer)
+   */
+  void build(const DivideConquer &base);
+
+  /*!
+   * \brief Nearest vertex of the base triangulation
+   * \param p query point
+   * \return vertex id (index in base.orderedPoints()), never a removed
+   * one, -1 if no vertex
+   */
+  int nearestVertex(const float2 &p) const;
+
+  /*!
+   * \brief Triangle of the base triangulation containing p
+   * \param p query point
+   */
+  LocateResult locate(const float2 &p) const;
+
+  /*!
+   * \brief Nearest vertex of many points
+   * \param points query points
+   * \param num_points number of query points
+   * \param vertices output vertex ids, num_points entries
+   * \param pool optional pool to split the batch on (may be null)
+   */
+  void nearestVertices(const float2 *points, size_t num_points, int *vertices,
+                       ThreadPool *pool = nullptr) const;
+
+  /*!
+   * \brief Point location of many points
+   * \param points query points
+   * \param num_points number of query points
+   * \param results output locations, num_points entries
+   * \param pool optional pool to split the batch on (may be null)
+   */
+  void locateAll(const float2 *points, size_t num_points,
+                 LocateResult *results, ThreadPool *pool = nullptr) const;
+
+  // number of levels, base included (0 before build)
+  size_t numLevels() const { return m_levels.size(); }
+
+private:
+  struct Level {
+    const DivideConquer *dc; // triangulation of this level
+    // neighbours of vertex v: [offset[v], offset[v + 1]) in neighbours
+    std::vector<size_t> offset;
+    std::vector<int> neighbours;
+    std::vector<int> to_finer; // vertex id on the level below
+  };
+
+  // adds a level on top of dc
+  void addLevel(const DivideConquer *dc, std::vector<int> to_finer);
+
+  // moves from vertex v to the nearest vertex of p on the level
+  int walkNearest(const Level &level, int v, const float2 &p) const;
+  // walks triangles from vertex v of the base to the one containing p
+  LocateResult walkLocate(int v, const float2 &p) const;
+
+private:
+  int m_ratio;
+  std::vector<Level> m_levels;      // finest (base) first
+  std::vector<Edge *> m_base_edges; // one edge out of each base vertex
+  uint64_t m_base_revision = 0;     // base->revision() at build
+  // triangulations of upper levels
+  std::vector<std::unique_ptr<DivideConquer>> m_upper;
+};
@@ -0,0 +1,141 @@
+#include "reorder.h"
+#include "delaunay.h"
+
+#include <algorithm>
+
+namespace {
+
+const int kGridBits = 16;
+const int kDigitBits = 11;
+const uint32_t kBuckets = 1u << kDigitBits;
+// points per task when computing curve indices
+const size_t kGrain = 1 << 14;
+
+/*!
+ * \brief Hilbert curve as a state machine, 4 levels (bits) per step
+ *
+ * The frame of the curve inside a quadrant is the one of its parent, flipped
+ * (both coordinates complemented) and/or swapped: 4 states, composed by xor.
+ * entry[state][x nibble][y nibble] holds the 4 base-4 digits of the nibbles
+ * (low byte) and the state after them (high byte).
+ */
+struct HilbertTable {
+  uint16_t entry[4][16][16];
+
+  HilbertTable() {
+    for (uint32_t state = 0; state < 4; state++) {
+      for (uint32_t x = 0; x < 16; x++) {
+        for (uint32_t y = 0; y < 16; y++) {
+          uint32_t s = state; // bit 0: swap, bit 1: flip
+          uint32_t digits = 0;
+          for (int bit = 3; bit >= 0; bit--) {
+            uint32_t rx = (x >> bit) & 1;
+            uint32_t ry = (y >> bit) & 1;
+            if (s & 2) {
+              rx ^= 1;
+              ry ^= 1;
+            }
+            if (s & 1) {
+              std::swap(rx, ry);
+            }
+            digits = (digits << 2) | ((3 * rx) ^ ry);
+            if (ry == 0) {
+              s ^= (rx == 1) ? 3 : 1;
+            }
+          }
+          entry[state][x][y] = static_cast<uint16_t>(digits | (s << 8));
+        }
+      }
+    }
+  }
+};
+
+// built on first use (safe from static initialization of other files)
+const HilbertTable &hilbertTable() {
+  static const HilbertTable table;
+  return table;
+}
+
+inline uint32_t hilbertIndex(const HilbertTable &table, uint32_t x,
+                             uint32_t y) {
+  uint32_t d = 0;
+  uint32_t state = 0;
+  for (int shift = kGridBits - 4; shift >= 0; shift -= 4) {
+    uint16_t entry = table.entry[state][(x >> shift) & 15][(y >> shift) & 15];
+    d = (d << 8) | (entry & 0xff);
+    state = entry >> 8;
+  }
+  return d;
+}
+
+} // namespace
+
+uint32_t HilbertOrder::index(uint32_t x, uint32_t y) {
+  return hilbertIndex(hilbertTable(), x, y);
+}
+
+template <typename T>
+void HilbertOrder::computeRanks(const Vec2<T> *points, size_t num_points,
+                                ThreadPool *pool,
+                                std::vector<uint32_t> &rank) {
+  rank.resize(num_points);
+  if (num_points == 0) {
+    return;
+  }
+
+  T min_x = points[0].x, max_x = points[0].x;
+  T min_y = points[0].y, max_y = points[0].y;
+  for (size_t i = 1; i < num_points; i++) {
+    min_x = std::min(min_x, points[i].x);
+    max_x = std::max(max_x, points[i].x);
+    min_y = std::min(min_y, points[i].y);
+    max_y = std::max(max_y, points[i].y);
+  }
+  // same scale on both axes: the curve is not stretched
+  const double extent = std::max(double(max_x) - min_x, double(max_y) - min_y);
+  const double scale = extent > 0 ? ((1u << kGridBits) - 1) / extent : 0.0;
+
+  m_keys.resize(num_points);
+  m_keys_tmp.resize(num_points);
+  const HilbertTable &table = hilbertTable();
+  auto body = [this, points, min_x, min_y, scale, &table](size_t begin,
+                                                          size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      uint32_t x = static_cast<uint32_t>((points[i].x - double(min_x)) * scale);
+      uint32_t y = static_cast<uint32_t>((points[i].y - double(min_y)) * scale);
+      m_keys[i] = (uint64_t(hilbertIndex(table, x, y)) << 32) | i;
+    }
+  };
+  ThreadPool::forRange(pool, num_points, kGrain, body);
+
+  // LSD radix sort on the curve index (stable: ties keep point order)
+  std::vector<uint32_t> &histogram = m_histogram;
+  histogram.resize(kBuckets);
+  for (int shift = 32; shift < 64; shift += kDigitBits) {
+    std::fill(histogram.begin(), histogram.end(), 0);
+    for (uint64_t key : m_keys) {
+      histogram[(key >> shift) & (kBuckets - 1)]++;
+    }
+    uint32_t offset = 0;
+    for (uint32_t &h : histogram) {
+      uint32_t count = h;
+      h = offset;
+      offset += count;
+    }
+    for (uint64_t key : m_keys) {
+      m_keys_tmp[histogram[(key >> shift) & (kBuckets - 1)]++] = key;
+    }
+    m_keys.swap(m_keys_tmp);
+  }
+
+  for (size_t r = 0; r < num_points; r++) {
+    rank[uint32_t(m_keys[r])] = static_cast<uint32_t>(r);
+  }
+}
+
+template void HilbertOrder::computeRanks(const float2 *, size_t, ThreadPool *,
+                                         std::vector<uint32_t> &);
+template void HilbertOrder::computeRanks(const double2 *, size_t, ThreadPool *,
+                                         std::vector<uint32_t> &);
+template void HilbertOrder::computeRanks(const int2 *, size_t, ThreadPool *,
+                                         std::vector<uint32_t> &);
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "thread_pool.h"
+
+template <typename T> struct Vec2;
+
+/*!
+ * \brief Orders points along a Hilbert curve
+ *
+ * Points are snapped on a 2^16 x 2^16 grid over their bounding box, and
+ * sorted by the index of their cell along the Hilbert curve (LSD radix sort
+ * on the 32 bits of the index). Consecutive ranks are close in the plane, so
+ * data indexed by rank has good locality for neighbourhood traversals.
+ * Buffers are kept between calls.
+ */
+class HilbertOrder {
+public:
+  /*!
+   * \brief Computes rank of each point along the curve
+   * \param points points to order
+   * \param num_points number of points
+   * \param pool optional pool computing curve indices (may be null)
+   * \param rank output rank of each point, a permutation of [0, num_points)
+   */
+  template <typename T>
+  void computeRanks(const Vec2<T> *points, size_t num_points,
+                    ThreadPool *pool, std::vector<uint32_t> &rank);
+
+  /*!
+   * \brief Hilbert index of a grid cell
+   * \param x column in [0, 2^16)
+   * \param y row in [0, 2^16)
+   * \return distance of the cell along the curve, in [0, 2^32)
+   */
+  static uint32_t index(uint32_t x, uint32_t y);
+
+private:
+  std::vector<uint64_t> m_keys; // curve index (high word) then point index
+  std::vector<uint64_t> m_keys_tmp;
+  std::vector<uint32_t> m_histogram;
+};
@@ -0,0 +1,319 @@
+#include "snapshot.h"
+
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char kMagic[8] = {'S', 'T', 'A', 'R', 'S', 'N', 'A', 'P'};
+// bumped on any layout change: older files are rejected
+const uint32_t kVersion = 1;
+// written natively, reads back swapped on a host of the other endianness
+const uint32_t kByteOrder = 0x01020304;
+// of sections and of the file size
+const size_t kAlignment = 64;
+
+enum Section {
+  kPoints,
+  kInputToVertex,
+  kOffsets,
+  kNeighbours,
+  kLenghts,
+  kTriangles,
+  kHull,
+  kTree,
+  kNumSections
+};
+
+// bytes per element of each section
+const size_t kElementSize[kNumSections] = {
+    sizeof(float2),   sizeof(int32_t),  sizeof(uint32_t),
+    sizeof(uint32_t), sizeof(float),    sizeof(uint32_t),
+    sizeof(uint32_t), sizeof(SnapshotEdge)};
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint64_t file_size;
+  uint64_t source_hash;
+  float min_d;
+  uint32_t reserved;
+  uint64_t offset[kNumSections]; // bytes from the start of the file
+  uint64_t count[kNumSections];  // elements
+  uint64_t payload_checksum;     // bytes after the header, padding included
+  uint64_t header_checksum;      // bytes of the header before it
+};
+
+static_assert(sizeof(float2) == 8 && sizeof(SnapshotEdge) == 12,
+              "snapshot sections are arrays of packed elements");
+static_assert(sizeof(int) == sizeof(int32_t), "input ids are stored as int");
+static_assert(offsetof(Header, header_checksum) == sizeof(Header) - 8,
+              "header checksum is the last word of the header");
+
+inline size_t alignUp(size_t size) {
+  return (size + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+const uint64_t kFnvBasis = 0xcbf29ce484222325ull;
+const uint64_t kFnvPrime = 0x100000001b3ull;
+
+// FNV-1a over 64 bits words, on 4 interleaved lanes (independent
+// multiplications), then mixed: every changed word changes its lane
+uint64_t hashBytes(const char *data, size_t size) {
+  uint64_t lanes[4] = {kFnvBasis, kFnvBasis ^ 1, kFnvBasis ^ 2,
+                       kFnvBasis ^ 3};
+  const size_t num_words = size / 8;
+  size_t w = 0;
+  for (; w + 4 <= num_words; w += 4) {
+    for (int k = 0; k < 4; k++) {
+      uint64_t word;
+      std::memcpy(&word, data + 8 * (w + k), 8);
+      lanes[k] = (lanes[k] ^ word) * kFnvPrime;
+    }
+  }
+  for (; w < num_words; w++) {
+    uint64_t word;
+    std::memcpy(&word, data + 8 * w, 8);
+    lanes[0] = (lanes[0] ^ word) * kFnvPrime;
+  }
+  for (size_t b = 8 * num_words; b < size; b++) {
+    lanes[1] = (lanes[1] ^ static_cast<unsigned char>(data[b])) * kFnvPrime;
+  }
+  uint64_t h = kFnvBasis ^ size;
+  for (uint64_t lane : lanes) {
+    h = (h ^ lane) * kFnvPrime;
+  }
+  // final avalanche (murmur3)
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  return h;
+}
+
+uint64_t payloadChecksum(const char *map, size_t size) {
+  const size_t begin = alignUp(sizeof(Header));
+  return hashBytes(map + begin, size - begin);
+}
+
+uint64_t headerChecksum(const Header &header) {
+  return hashBytes(reinterpret_cast<const char *>(&header),
+                   offsetof(Header, header_checksum));
+}
+
+// copies a section at its offset
+void writeSection(char *map, const Header &header, Section section,
+                  const void *data) {
+  if (header.count[section] > 0) {
+    std::memcpy(map + header.offset[section], data,
+                header.count[section] * kElementSize[section]);
+  }
+}
+
+} // namespace
+
+uint64_t hashPoints(const float2 *points, size_t num_points) {
+  return hashBytes(reinterpret_cast<const char *>(points),
+                   num_points * sizeof(float2));
+}
+
+void saveSnapshot(const std::string &path, const DivideConquer &dc,
+                  const TriangulationMesh &mesh,
+                  const std::vector<Edge *> &tree, float min_d,
+                  uint64_t source_hash) {
+  std::vector<SnapshotEdge> tree_edges;
+  tree_edges.reserve(tree.size());
+  for (Edge *e : tree) {
+    tree_edges.push_back(SnapshotEdge{static_cast<uint32_t>(e->Org()),
+                                      static_cast<uint32_t>(e->Dest()),
+                                      e->getQuadEdge()->lenght()});
+  }
+
+  Header header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.byte_order = kByteOrder;
+  header.source_hash = source_hash;
+  header.min_d = min_d;
+  header.count[kPoints] = dc.orderedPoints().size();
+  header.count[kInputToVertex] = dc.inputToVertex().size();
+  header.count[kOffsets] = mesh.offsets.size();
+  header.count[kNeighbours] = mesh.neighbours.size();
+  header.count[kLenghts] = mesh.lenghts.size();
+  header.count[kTriangles] = mesh.triangles.size();
+  header.count[kHull] = mesh.hull.size();
+  header.count[kTree] = tree_edges.size();
+  size_t size = alignUp(sizeof(Header));
+  for (int s = 0; s < kNumSections; s++) {
+    header.offset[s] = size;
+    size += alignUp(header.count[s] * kElementSize[s]);
+  }
+  header.file_size = size;
+
+  // written aside, then renamed over path
+  const std::string temporary = path + ".tmp";
+  int fd = ::open(temporary.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    throw std::runtime_error("saveSnapshot: cannot create " + temporary);
+  }
+  // blocks are allocated here: a full disk fails now, not as a fault while
+  // writing the mapping
+  void *map = MAP_FAILED;
+  if (::posix_fallocate(fd, 0, static_cast<off_t>(size)) == 0) {
+    map = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  if (map == MAP_FAILED) {
+    ::close(fd);
+    ::unlink(temporary.c_str());
+    throw std::runtime_error("saveSnapshot: cannot map " + temporary);
+  }
+  // the file is zero filled: so is padding
+  char *bytes = static_cast<char *>(map);
+  writeSection(bytes, header, kPoints, dc.orderedPoints().data());
+  writeSection(bytes, header, kInputToVertex, dc.inputToVertex().data());
+  writeSection(bytes, header, kOffsets, mesh.offsets.data());
+  writeSection(bytes, header, kNeighbours, mesh.neighbours.data());
+  writeSection(bytes, header, kLenghts, mesh.lenghts.data());
+  writeSection(bytes, header, kTriangles, mesh.triangles.data());
+  writeSection(bytes, header, kHull, mesh.hull.data());
+  writeSection(bytes, header, kTree, tree_edges.data());
+  header.payload_checksum = payloadChecksum(bytes, size);
+  header.header_checksum = headerChecksum(header);
+  std::memcpy(bytes, &header, sizeof(header));
+
+  bool written = ::munmap(map, size) == 0;
+  written = ::close(fd) == 0 && written;
+  if (!written || ::rename(temporary.c_str(), path.c_str()) != 0) {
+    ::unlink(temporary.c_str());
+    throw std::runtime_error("saveSnapshot: cannot write " + path);
+  }
+}
+
+Snapshot::~Snapshot() { close(); }
+
+void Snapshot::open(const std::string &path, bool verify) {
+  close();
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("Snapshot: cannot open " + path);
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    throw std::runtime_error("Snapshot: cannot stat " + path);
+  }
+  const size_t size = static_cast<size_t>(st.st_size);
+  if (size < alignUp(sizeof(Header))) {
+    ::close(fd);
+    throw std::runtime_error("Snapshot: truncated file " + path);
+  }
+  // shared: pages come from the page cache, as in other processes
+  void *map = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd); // mapping stays valid
+  if (map == MAP_FAILED) {
+    throw std::runtime_error("Snapshot: cannot map " + path);
+  }
+  m_map = static_cast<const char *>(map);
+  m_map_size = size;
+
+  // header, then sections within the file (counts are not trusted before)
+  const Header &header = *reinterpret_cast<const Header *>(m_map);
+  const char *error = nullptr;
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+    error = "not a snapshot ";
+  } else if (header.version != kVersion) {
+    error = "unsupported version of ";
+  } else if (header.byte_order != kByteOrder) {
+    error = "other endianness in ";
+  } else if (header.header_checksum != headerChecksum(header)) {
+    error = "corrupt header in ";
+  } else if (header.file_size != size) {
+    error = "truncated file ";
+  }
+  for (int s = 0; s < kNumSections && !error; s++) {
+    const uint64_t offset = header.offset[s];
+    if (offset % kAlignment != 0 || offset > size ||
+        header.count[s] > (size - offset) / kElementSize[s]) {
+      error = "section out of file in ";
+    }
+  }
+  // adjacency of the last vertex ends with the neighbours
+  const uint64_t num_vertices = header.count[kPoints];
+  const uint64_t num_offsets = header.count[kOffsets];
+  if (!error &&
+      (num_offsets > num_vertices + 1 ||
+       (num_vertices > 0 && num_offsets != num_vertices + 1) ||
+       header.count[kLenghts] != header.count[kNeighbours] ||
+       header.count[kTriangles] % 3 != 0 ||
+       (num_offsets > 0 &&
+        reinterpret_cast<const uint32_t *>(
+            m_map + header.offset[kOffsets])[num_offsets - 1] !=
+            header.count[kNeighbours]))) {
+    error = "inconsistent sections in ";
+  }
+  if (!error && verify &&
+      header.payload_checksum != payloadChecksum(m_map, size)) {
+    error = "checksum mismatch in ";
+  }
+  if (error) {
+    close();
+    throw std::runtime_error(std::string("Snapshot: ") + error + path);
+  }
+
+  m_num_vertices = num_vertices;
+  m_num_input = header.count[kInputToVertex];
+  m_num_adjacencies = header.count[kNeighbours];
+  m_num_triangles = header.count[kTriangles] / 3;
+  m_hull_size = header.count[kHull];
+  m_num_tree_edges = header.count[kTree];
+  m_points = reinterpret_cast<const float2 *>(m_map + header.offset[kPoints]);
+  m_input_to_vertex =
+      reinterpret_cast<const int32_t *>(m_map + header.offset[kInputToVertex]);
+  m_offsets =
+      reinterpret_cast<const uint32_t *>(m_map + header.offset[kOffsets]);
+  m_neighbours =
+      reinterpret_cast<const uint32_t *>(m_map + header.offset[kNeighbours]);
+  m_lenghts = reinterpret_cast<const float *>(m_map + header.offset[kLenghts]);
+  m_triangles =
+      reinterpret_cast<const uint32_t *>(m_map + header.offset[kTriangles]);
+  m_hull = reinterpret_cast<const uint32_t *>(m_map + header.offset[kHull]);
+  m_tree =
+      reinterpret_cast<const SnapshotEdge *>(m_map + header.offset[kTree]);
+}
+
+void Snapshot::close() {
+  if (m_map) {
+    ::munmap(const_cast<char *>(m_map), m_map_size);
+  }
+  m_map = nullptr;
+  m_map_size = 0;
+  m_num_vertices = 0;
+  m_num_input = 0;
+  m_num_adjacencies = 0;
+  m_num_triangles = 0;
+  m_hull_size = 0;
+  m_num_tree_edges = 0;
+  m_points = nullptr;
+  m_input_to_vertex = nullptr;
+  m_offsets = nullptr;
+  m_neighbours = nullptr;
+  m_lenghts = nullptr;
+  m_triangles = nullptr;
+  m_hull = nullptr;
+  m_tree = nullptr;
+}
+
+uint64_t Snapshot::sourceHash() const {
+  return m_map ? reinterpret_cast<const Header *>(m_map)->source_hash : 0;
+}
+
+float Snapshot::minD() const {
+  return m_map ? reinterpret_cast<const Header *>(m_map)->min_d : 0.0f;
+}
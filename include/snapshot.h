@@ -0,0 +1,115 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "delaunay.h"
+#include "mesh.h"
+
+// spanning tree edge of a snapshot
+struct SnapshotEdge {
+  uint32_t u;
+  uint32_t v;
+  float lenght; // squared, as BasicQuadEdge::lenght()
+};
+
+/*!
+ * \brief Hash of points, identifies the input of a snapshot
+ * Word-wise over the bytes of the points: equal arrays, equal hashes.
+ */
+uint64_t hashPoints(const float2 *points, size_t num_points);
+
+/*!
+ * \brief Saves a triangulation and its spanning tree to a snapshot file
+ *
+ * The file is a header followed by sections laid out as their in-memory
+ * arrays (native endianness, 64 bytes aligned): ordered points, input to
+ * vertex ids, mesh offsets, neighbours, lenghts, triangles and hull, then
+ * spanning tree edges. A checksum covers the header and one covers the
+ * sections. The file is written aside then renamed over path, so processes
+ * mapping a previous version keep reading it unchanged.
+ * \param dc computed triangulation
+ * \param mesh export of dc (exportMesh)
+ * \param tree spanning tree of dc (computeMinD), min_d its result
+ * \param source_hash hashPoints of the input, 0 if unknown
+ * throws std::runtime_error if the file cannot be written
+ */
+void saveSnapshot(const std::string &path, const DivideConquer &dc,
+                  const TriangulationMesh &mesh,
+                  const std::vector<Edge *> &tree, float min_d,
+                  uint64_t source_hash = 0);
+
+/*!
+ * \brief Read-only view of a snapshot file
+ *
+ * The file is memory mapped shared: arrays point into the mapping, nothing
+ * is parsed nor copied, and processes mapping the same file share its
+ * pages through the page cache. Arrays stay valid until the next open,
+ * close or destruction.
+ */
+class Snapshot {
+public:
+  Snapshot() = default;
+  ~Snapshot();
+
+  Snapshot(const Snapshot &) = delete;
+  Snapshot &operator=(const Snapshot &) = delete;
+
+  /*!
+   * \brief Maps a snapshot file, previous mapping is released
+   * \param verify also checks the checksum of sections, which reads the
+   * whole file once; the header (magic, version, sizes) is always checked
+   * throws std::runtime_error if the file cannot be mapped, is not a
+   * snapshot of this version, is truncated or fails a checksum
+   */
+  void open(const std::string &path, bool verify = true);
+  void close();
+
+  bool isOpen() const { return m_map != nullptr; }
+  // hashPoints of the input given to saveSnapshot: tells a stale file
+  uint64_t sourceHash() const;
+  float minD() const;
+
+  size_t numVertices() const { return m_num_vertices; }
+  // vertex positions, DivideConquer::orderedPoints()
+  const float2 *points() const { return m_points; }
+  // vertex id of each input point, DivideConquer::inputToVertex()
+  const int32_t *inputToVertex() const { return m_input_to_vertex; }
+  size_t numInputPoints() const { return m_num_input; }
+
+  // adjacency as in TriangulationMesh: numVertices() + 1 offsets
+  const uint32_t *offsets() const { return m_offsets; }
+  const uint32_t *neighbours() const { return m_neighbours; }
+  const float *lenghts() const { return m_lenghts; }
+  size_t numEdges() const { return m_num_adjacencies / 2; }
+  uint32_t degree(uint32_t v) const { return m_offsets[v + 1] - m_offsets[v]; }
+
+  const uint32_t *triangles() const { return m_triangles; }
+  size_t numTriangles() const { return m_num_triangles; }
+  const uint32_t *hull() const { return m_hull; }
+  size_t hullSize() const { return m_hull_size; }
+
+  const SnapshotEdge *treeEdges() const { return m_tree; }
+  size_t numTreeEdges() const { return m_num_tree_edges; }
+
+  size_t fileSize() const { return m_map_size; }
+
+private:
+  const char *m_map = nullptr;
+  size_t m_map_size = 0;
+  size_t m_num_vertices = 0;
+  size_t m_num_input = 0;
+  size_t m_num_adjacencies = 0;
+  size_t m_num_triangles = 0;
+  size_t m_hull_size = 0;
+  size_t m_num_tree_edges = 0;
+  const float2 *m_points = nullptr;
+  const int32_t *m_input_to_vertex = nullptr;
+  const uint32_t *m_offsets = nullptr;
+  const uint32_t *m_neighbours = nullptr;
+  const float *m_lenghts = nullptr;
+  const uint32_t *m_triangles = nullptr;
+  const uint32_t *m_hull = nullptr;
+  const SnapshotEdge *m_tree = nullptr;
+};
@@ -0,0 +1,76 @@
+#include "stats.h"
+
+#include <iomanip>
+
+namespace {
+
+void writeDepth(std::ostream &out, const DepthStats &d) {
+  out << "{\"merges\": " << d.merges
+      << ", \"tangent_iterations\": " << d.tangent_iterations
+      << ", \"merge_iterations\": " << d.merge_iterations
+      << ", \"edges_created\": " << d.edges_created
+      << ", \"edges_disconnected\": " << d.edges_disconnected
+      << ", \"incircle_calls\": " << d.incircle_calls
+      << ", \"ccw_calls\": " << d.ccw_calls << "}";
+}
+
+} // namespace
+
+DepthStats &DepthStats::operator+=(const DepthStats &o) {
+  merges += o.merges;
+  tangent_iterations += o.tangent_iterations;
+  merge_iterations += o.merge_iterations;
+  edges_created += o.edges_created;
+  edges_disconnected += o.edges_disconnected;
+  incircle_calls += o.incircle_calls;
+  ccw_calls += o.ccw_calls;
+  return *this;
+}
+
+DepthStats TriangulationStats::total() const {
+  DepthStats sum;
+  for (const DepthStats &d : depths) {
+    sum += d;
+  }
+  return sum;
+}
+
+void TriangulationStats::writeJson(std::ostream &out) const {
+  out << "{\"phases\": {\"sort\": " << phase_times.sort
+      << ", \"dedup\": " << phase_times.dedup
+      << ", \"triangulation\": " << phase_times.triangulation
+      << ", \"mst\": " << phase_times.mst << "}";
+  out << ", \"predicates\": {\"orient_filtered\": "
+      << predicates.orient_filtered
+      << ", \"orient_exact\": " << predicates.orient_exact
+      << ", \"incircle_filtered\": " << predicates.incircle_filtered
+      << ", \"incircle_exact\": " << predicates.incircle_exact << "}";
+  out << ", \"max_depth\": " << maxDepth() << ", \"total\": ";
+  writeDepth(out, total());
+  out << ", \"depths\": [";
+  for (size_t d = 0; d < depths.size(); d++) {
+    out << (d ? ", " : "");
+    writeDepth(out, depths[d]);
+  }
+  out << "]}";
+}
+
+void TriangulationStats::writeChromeTrace(std::ostream &out) const {
+  // complete events ("X"), times in microseconds
+  std::ios::fmtflags flags = out.flags();
+  std::streamsize precision = out.precision();
+  out << std::fixed << std::setprecision(3);
+  out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+  for (size_t i = 0; i < events.size(); i++) {
+    const TraceEvent &e = events[i];
+    out << "  {\"name\": \"" << e.name << "\", \"cat\": \""
+        << (e.depth < 0 ? "phase" : "merge")
+        << "\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << e.thread
+        << ", \"ts\": " << e.begin * 1e6 << ", \"dur\": " << e.duration * 1e6
+        << ", \"args\": {\"depth\": " << e.depth << "}}"
+        << (i + 1 < events.size() ? ",\n" : "\n");
+  }
+  out << "]}\n";
+  out.flags(flags);
+  out.precision(precision);
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "predicates.h"
+
+// wall time of the phases of last computations, in seconds
+struct PhaseTimes {
+  double preprocess = 0;    // sort and duplicates removal
+  double sort = 0;          // part of preprocess: keys and radix sort
+  double dedup = 0;         // part of preprocess: duplicates removal
+  double triangulation = 0; // divide and conquer
+  double mst = 0;           // last computeMinD (any backend)
+};
+
+/*!
+ * \brief Work done at one depth of the divide and conquer recursion
+ * Depth 0 is the merge of the whole set, leaves are the 2 and 3 points cases.
+ */
+struct DepthStats {
+  uint64_t merges = 0;             // merges of two halves
+  uint64_t tangent_iterations = 0; // steps of the lower common tangent walk
+  uint64_t merge_iterations = 0;   // cross edges added by merge loops
+  uint64_t edges_created = 0;
+  uint64_t edges_disconnected = 0;
+  uint64_t incircle_calls = 0; // insideCircle calls
+  uint64_t ccw_calls = 0;      // ccw calls (leftOf, rightOf, isValid too)
+
+  DepthStats &operator+=(const DepthStats &o);
+};
+
+/*!
+ * \brief Timed section of a triangulation, for trace export
+ * Times are in seconds since the start of computeTriangulation.
+ */
+struct TraceEvent {
+  const char *name; // static string
+  int thread;       // worker index
+  int depth;        // recursion depth, -1 for a phase
+  double begin;
+  double duration;
+};
+
+/*!
+ * \brief Statistics of the last triangulation of a DivideConquer
+ *
+ * Counters and trace events are only collected when compiled with
+ * DELAUNAY_STATS (they stay empty otherwise); phase times are always set.
+ */
+struct TriangulationStats {
+  PhaseTimes phase_times;
+  std::vector<DepthStats> depths; // indexed by recursion depth
+  // predicate evaluation paths, process wide, during the triangulation
+  PredicateCounters predicates;
+  std::vector<TraceEvent> events; // phases, and merges of the top depths
+
+  // deepest recursion level, -1 if nothing was recorded
+  int maxDepth() const { return static_cast<int>(depths.size()) - 1; }
+  // sum over all depths
+  DepthStats total() const;
+
+  // writes counters and phase times as a single json object
+  void writeJson(std::ostream &out) const;
+  // writes events in the Chrome trace format (chrome://tracing, Perfetto)
+  void writeChromeTrace(std::ostream &out) const;
+};
@@ -0,0 +1,450 @@
+#include "streaming.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+// memory of one retained vertex: its ~3 quad edges, point, ids and flags
+const size_t kBytesPerVertex = 3 * sizeof(QuadEdge) + sizeof(float2) +
+                               sizeof(uint64_t) + sizeof(Edge *) +
+                               sizeof(int) + 2 * sizeof(char);
+// smallest strip, whatever the budget
+const size_t kMinStripSize = 64;
+
+// (x, y) order of the input
+inline bool lessXY(const float2 &a, const float2 &b) {
+  return a.x < b.x || (a.x == b.x && a.y < b.y);
+}
+
+void writeAll(std::FILE *file, const void *data, size_t size, size_t count) {
+  if (count && std::fwrite(data, size, count, file) != count) {
+    throw std::runtime_error("stream: write failed");
+  }
+}
+
+void readAll(std::FILE *file, void *data, size_t size, size_t count) {
+  if (count && std::fread(data, size, count, file) != count) {
+    throw std::runtime_error("stream: truncated file");
+  }
+}
+
+void writeBlockTo(std::FILE *file, const std::vector<StreamEdge> &edges,
+                  const std::vector<uint64_t> &closed) {
+  StreamBlockHeader header{edges.size(), closed.size()};
+  writeAll(file, &header, sizeof(header), 1);
+  writeAll(file, edges.data(), sizeof(StreamEdge), edges.size());
+  writeAll(file, closed.data(), sizeof(uint64_t), closed.size());
+}
+
+} // namespace
+
+/*********************** StreamingDelaunay ********************/
+
+StreamingDelaunay::StreamingDelaunay(const std::string &path,
+                                     size_t memory_budget) {
+  // half of the budget for the strip, half for what is retained of the past
+  m_strip_size = std::max(kMinStripSize, memory_budget / 2 / kBytesPerVertex);
+  m_buffer.reserve(m_strip_size + 2);
+
+  m_file = std::fopen(path.c_str(), "wb");
+  if (!m_file) {
+    throw std::runtime_error("StreamingDelaunay: cannot open " + path);
+  }
+}
+
+StreamingDelaunay::~StreamingDelaunay() {
+  if (m_file) {
+    std::fclose(m_file);
+  }
+}
+
+void StreamingDelaunay::addPoints(const float2 *points, size_t num_points) {
+  for (size_t i = 0; i < num_points; i++) {
+    const float2 &p = points[i];
+    if (m_num_vertices > 0) {
+      if (lessXY(p, m_last)) {
+        throw std::invalid_argument("StreamingDelaunay: points not sorted");
+      }
+      if (!lessXY(m_last, p)) {
+        continue; // same point
+      }
+    }
+    m_last = p;
+    m_buffer.push_back(p);
+    m_num_vertices++;
+
+    // keep at least 2 points buffered: a strip always has an edge
+    if (m_buffer.size() >= m_strip_size + 2) {
+      processStrip(m_strip_size);
+    }
+  }
+}
+
+void StreamingDelaunay::finish() {
+  if (!m_file) {
+    return;
+  }
+  if (m_buffer.size() >= 2) {
+    processStrip(m_buffer.size());
+  } else if (m_buffer.size() == 1) {
+    // a single point at all: closed without any edge
+    m_block_closed.push_back(m_num_vertices - 1);
+    m_buffer.clear();
+  }
+  retire(0.0f, true);
+
+  std::fclose(m_file);
+  m_file = nullptr;
+}
+
+void StreamingDelaunay::processStrip(size_t num_points) {
+  std::vector<float2> &points = m_dc.m_ordered_points;
+  const int first = static_cast<int>(points.size());
+  const uint64_t first_global = m_num_vertices - m_buffer.size();
+
+  // local ids of the strip follow the retained vertices
+  points.insert(points.end(), m_buffer.begin(), m_buffer.begin() + num_points);
+  for (size_t i = 0; i < num_points; i++) {
+    m_global_id.push_back(first_global + i);
+    m_final.push_back(0);
+  }
+  m_buffer.erase(m_buffer.begin(), m_buffer.begin() + num_points);
+  m_peak_retained = std::max(m_peak_retained, points.size());
+
+  Edge *strip_left;
+  Edge *strip_right;
+  m_dc.recursiveDelaunay(strip_left, strip_right, first,
+                         static_cast<int>(points.size()) - 1);
+  if (!m_left) {
+    m_left = strip_left;
+  } else {
+    m_dc.mergeHalves(m_left, m_right, strip_left, strip_right);
+  }
+  m_right = strip_right;
+
+  // next points have x >= x of the last one
+  retire(points.back().x, false);
+}
+
+bool StreamingDelaunay::isFinalTriangle(Edge *e, double frontier_x) const {
+  Edge *next = e->Lnext();
+  if (next->Lnext()->Lnext() != e) {
+    return false; // outer face
+  }
+  const std::vector<float2> &points = m_dc.m_ordered_points;
+  const float2 &a = points[e->Org()];
+  const float2 &b = points[e->Dest()];
+  const float2 &c = points[next->Dest()];
+
+  // circumcenter relative to a
+  double bx = double(b.x) - a.x;
+  double by = double(b.y) - a.y;
+  double cx = double(c.x) - a.x;
+  double cy = double(c.y) - a.y;
+  double d = 2.0 * (bx * cy - by * cx);
+  // nearly flat triangles have unreliable (huge) circles: never final
+  if (!(d > 1e-6 * 2.0 * (std::fabs(bx * cy) + std::fabs(by * cx)))) {
+    return false;
+  }
+  double b2 = bx * bx + by * by;
+  double c2 = cx * cx + cy * cy;
+  double ux = (cy * b2 - by * c2) / d;
+  double uy = (bx * c2 - cx * b2) / d;
+  double r = std::sqrt(ux * ux + uy * uy);
+
+  // conservative: a triangle wrongly left open only stays in memory longer
+  double xmax = a.x + ux + r;
+  double margin = 1e-9 * (std::fabs(double(a.x)) + std::fabs(ux) + r);
+  return xmax + margin < frontier_x;
+}
+
+void StreamingDelaunay::retire(float frontier_x, bool all) {
+  const size_t n = m_dc.m_ordered_points.size();
+  m_dc.vertexEdges(m_vertex_edge);
+
+  // 1. stars made only of final triangles never change again
+  if (!all) {
+    for (size_t v = 0; v < n; v++) {
+      Edge *first = m_vertex_edge[v];
+      if (m_final[v] || !first) {
+        continue;
+      }
+      bool is_final = true;
+      Edge *e = first;
+      do {
+        if (!isFinalTriangle(e, frontier_x)) {
+          is_final = false;
+          break;
+        }
+        e = e->Onext();
+      } while (e != first);
+      m_final[v] = is_final;
+    }
+  }
+
+  // 2. retire final vertices with final neighbours only: every vertex still
+  // touched by a merge keeps its complete ring
+  m_retired.assign(n, all ? 1 : 0);
+  for (size_t v = 0; v < n && !all; v++) {
+    Edge *first = m_vertex_edge[v];
+    if (!m_final[v] || !first) {
+      continue;
+    }
+    bool retired = true;
+    Edge *e = first;
+    do {
+      if (!m_final[e->Dest()]) {
+        retired = false;
+        break;
+      }
+      e = e->Onext();
+    } while (e != first);
+    m_retired[v] = retired;
+  }
+
+  // 3. write and remove edges touching retired vertices
+  m_vertex_edge.clear(); // reused for edges to remove
+  for (const auto &arena : m_dc.m_quad_edges) {
+    arena->forEach([this](QuadEdge &q) {
+      if (!q.alive()) {
+        return;
+      }
+      int u = q.e[0].Org();
+      int v = q.e[0].Dest();
+      if (m_retired[u] || m_retired[v]) {
+        m_block_edges.push_back(
+            StreamEdge{m_global_id[u], m_global_id[v], q.lenght(), 0});
+        m_vertex_edge.push_back(q.e);
+      }
+    });
+  }
+  for (Edge *e : m_vertex_edge) {
+    m_dc.disconnectEdge(e);
+  }
+  m_num_edges += m_vertex_edge.size();
+
+  // 4. compact: kept vertices keep their order, so their sort too
+  m_remap.resize(n);
+  size_t kept = 0;
+  for (size_t v = 0; v < n; v++) {
+    if (m_retired[v]) {
+      m_block_closed.push_back(m_global_id[v]);
+      m_remap[v] = -1;
+      continue;
+    }
+    m_remap[v] = static_cast<int>(kept);
+    m_dc.m_ordered_points[kept] = m_dc.m_ordered_points[v];
+    m_global_id[kept] = m_global_id[v];
+    m_final[kept] = m_final[v];
+    kept++;
+  }
+  m_dc.m_ordered_points.resize(kept);
+  m_global_id.resize(kept);
+  m_final.resize(kept);
+  for (const auto &arena : m_dc.m_quad_edges) {
+    arena->forEach([this](QuadEdge &q) {
+      if (q.alive()) {
+        q.e[0].vertex = m_remap[q.e[0].vertex];
+        q.e[2].vertex = m_remap[q.e[2].vertex];
+      }
+    });
+  }
+  if (kept == 0) {
+    m_left = nullptr;
+    m_right = nullptr;
+  }
+
+  writeBlock();
+}
+
+void StreamingDelaunay::writeBlock() {
+  if (m_block_edges.empty() && m_block_closed.empty()) {
+    return;
+  }
+  writeBlockTo(m_file, m_block_edges, m_block_closed);
+  m_block_edges.clear();
+  m_block_closed.clear();
+}
+
+/*********************** StreamingMst *************************/
+
+float StreamingMst::computeMinD(const std::string &path,
+                                const std::string &tree_path) {
+  std::FILE *in = std::fopen(path.c_str(), "rb");
+  if (!in) {
+    throw std::runtime_error("StreamingMst: cannot open " + path);
+  }
+  std::FILE *out = nullptr;
+  if (!tree_path.empty()) {
+    out = std::fopen(tree_path.c_str(), "wb");
+    if (!out) {
+      std::fclose(in);
+      throw std::runtime_error("StreamingMst: cannot open " + tree_path);
+    }
+  }
+
+  m_forest.clear();
+  m_closed.clear();
+  m_max_lenght = 0;
+  m_num_tree_edges = 0;
+  std::vector<StreamEdge> block;
+  std::vector<uint64_t> closed;
+  const std::vector<uint64_t> no_closed;
+
+  try {
+    StreamBlockHeader header;
+    while (std::fread(&header, sizeof(header), 1, in) == 1) {
+      block.resize(header.num_edges);
+      closed.resize(header.num_closed);
+      readAll(in, block.data(), sizeof(StreamEdge), block.size());
+      readAll(in, closed.data(), sizeof(uint64_t), closed.size());
+
+      mergeBlock(block);
+      for (uint64_t c : closed) {
+        m_closed[c];
+      }
+      reduceForest();
+
+      if (out && !m_tree_edges.empty()) {
+        writeBlockTo(out, m_tree_edges, no_closed);
+      }
+      m_tree_edges.clear();
+    }
+
+    // whole graph seen: what remains is final
+    for (const ForestEdge &e : m_forest) {
+      emit(e);
+    }
+    m_forest.clear();
+    if (out && !m_tree_edges.empty()) {
+      writeBlockTo(out, m_tree_edges, no_closed);
+    }
+    m_tree_edges.clear();
+  } catch (...) {
+    std::fclose(in);
+    if (out) {
+      std::fclose(out);
+    }
+    throw;
+  }
+
+  std::fclose(in);
+  if (out) {
+    std::fclose(out);
+  }
+  return std::sqrt(m_max_lenght);
+}
+
+void StreamingMst::mergeBlock(const std::vector<StreamEdge> &block) {
+  // MST(A u B) = MST(MST(A) u B)
+  m_candidates.swap(m_forest);
+  m_forest.clear();
+  for (const StreamEdge &e : block) {
+    m_candidates.push_back(ForestEdge{e.u, e.v, e.lenght, e.u, e.v});
+  }
+
+  // compact ids for the Kruskal engine
+  m_local_id.clear();
+  m_edges.clear();
+  auto localId = [this](uint64_t id) {
+    auto it = m_local_id.emplace(id, static_cast<int>(m_local_id.size()));
+    return it.first->second;
+  };
+  for (const ForestEdge &e : m_candidates) {
+    int u = localId(e.u);
+    int v = localId(e.v);
+    m_edges.push_back(WeightedEdge{u, v, e.lenght});
+  }
+
+  m_kruskal.computeSolution(m_edges, static_cast<int>(m_local_id.size()));
+  for (uint32_t idx : m_kruskal.retrieveSol()) {
+    m_forest.push_back(m_candidates[idx]);
+  }
+  m_candidates.clear();
+}
+
+void StreamingMst::reduceForest() {
+  // forest edges through each closed vertex
+  for (auto &closed : m_closed) {
+    closed.second.clear();
+  }
+  for (size_t i = 0; i < m_forest.size(); i++) {
+    for (uint64_t end : {m_forest[i].u, m_forest[i].v}) {
+      auto it = m_closed.find(end);
+      if (it != m_closed.end()) {
+        it->second.push_back(static_cast<int>(i));
+      }
+    }
+  }
+  m_dead.assign(m_forest.size(), 0);
+
+  std::vector<uint64_t> pending;
+  for (const auto &closed : m_closed) {
+    if (closed.second.size() <= 2) {
+      pending.push_back(closed.first);
+    }
+  }
+
+  auto other = [](const ForestEdge &e, uint64_t end) {
+    return e.u == end ? e.v : e.u;
+  };
+
+  while (!pending.empty()) {
+    uint64_t c = pending.back();
+    pending.pop_back();
+    auto it = m_closed.find(c);
+    if (it == m_closed.end() || it->second.size() > 2) {
+      continue;
+    }
+    std::vector<int> edges = it->second;
+    m_closed.erase(it);
+
+    if (edges.size() == 1) {
+      // leaf: no cycle can ever go through its edge
+      const int i = edges[0];
+      emit(m_forest[i]);
+      m_dead[i] = 1;
+      auto o = m_closed.find(other(m_forest[i], c));
+      if (o != m_closed.end()) {
+        std::vector<int> &list = o->second;
+        list.erase(std::find(list.begin(), list.end(), i));
+        if (list.size() <= 2) {
+          pending.push_back(o->first);
+        }
+      }
+    } else if (edges.size() == 2) {
+      // any cycle through c uses both edges: lighter one is never its max
+      int light = edges[0];
+      int heavy = edges[1];
+      if (m_forest[heavy].lenght < m_forest[light].lenght) {
+        std::swap(light, heavy);
+      }
+      emit(m_forest[light]);
+      m_dead[light] = 1;
+      uint64_t o = other(m_forest[light], c);
+      ForestEdge &h = m_forest[heavy];
+      (h.u == c ? h.u : h.v) = o;
+      auto oit = m_closed.find(o);
+      if (oit != m_closed.end()) {
+        std::replace(oit->second.begin(), oit->second.end(), light, heavy);
+      }
+    }
+  }
+
+  // drop emitted edges
+  size_t kept = 0;
+  for (size_t i = 0; i < m_forest.size(); i++) {
+    if (!m_dead[i]) {
+      m_forest[kept++] = m_forest[i];
+    }
+  }
+  m_forest.resize(kept);
+}
+
+void StreamingMst::emit(const ForestEdge &e) {
+  m_max_lenght = std::max(m_max_lenght, e.lenght);
+  m_num_tree_edges++;
+  m_tree_edges.push_back(StreamEdge{e.orig_u, e.orig_v, e.lenght, 0});
+}
@@ -0,0 +1,155 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "delaunay.h"
+#include "kruskal.h"
+
+/*!
+ * \brief Edge record of a streamed triangulation (or spanning tree) file
+ *
+ * Files are a sequence of blocks: a StreamBlockHeader, num_edges StreamEdge
+ * then num_closed vertex ids (uint64_t). A vertex is closed once all of its
+ * edges have been written, in this block or in an earlier one.
+ */
+struct StreamEdge {
+  uint64_t u;      // global vertex id (rank of the point in input order)
+  uint64_t v;      // global vertex id
+  float lenght;    // lenght squared
+  uint32_t unused; // explicit padding, written as 0
+};
+
+struct StreamBlockHeader {
+  uint64_t num_edges;
+  uint64_t num_closed;
+};
+
+/*!
+ * \brief Out-of-core Delaunay triangulation of x-then-y sorted points
+ *
+ * Points are consumed in vertical strips sized from the memory budget. Each
+ * strip is triangulated and merged with the retained triangulation, then
+ * triangles whose circumcircle lies left of the strip end are final: no later
+ * point can be inside them. Vertices whose triangles and neighbours are all
+ * final are retired, their edges written to disk, and the retained
+ * triangulation is compacted. Only a band along the right hull stays in
+ * memory.
+ */
+class StreamingDelaunay {
+public:
+  /*!
+   * \param path output file, see StreamEdge
+   * \param memory_budget bytes of points and edges kept in memory
+   */
+  StreamingDelaunay(const std::string &path, size_t memory_budget);
+  ~StreamingDelaunay();
+
+  StreamingDelaunay(const StreamingDelaunay &) = delete;
+  StreamingDelaunay &operator=(const StreamingDelaunay &) = delete;
+
+  /*!
+   * \brief Adds points following (x then y) all points added before
+   * \param points sorted points, duplicates of the previous point are skipped
+   * \param num_points number of points
+   * throws std::invalid_argument if points are not sorted
+   */
+  void addPoints(const float2 *points, size_t num_points);
+
+  // triangulates remaining points and writes all remaining edges
+  void finish();
+
+  // number of distinct vertices added
+  uint64_t numVertices() const { return m_num_vertices; }
+  // number of edges written
+  uint64_t numEdges() const { return m_num_edges; }
+  // maximum number of vertices in memory at once
+  size_t peakRetainedVertices() const { return m_peak_retained; }
+
+private:
+  // triangulates the first num_points buffered points and merges them
+  void processStrip(size_t num_points);
+  // retires final vertices left of frontier_x and writes their edges
+  void retire(float frontier_x, bool all);
+  // true if no point of x >= frontier_x can be inside left face of e
+  bool isFinalTriangle(Edge *e, double frontier_x) const;
+  void writeBlock();
+
+private:
+  DivideConquer m_dc; // retained triangulation, vertex id = local id
+  std::vector<uint64_t> m_global_id; // global id of each local vertex
+  std::vector<char> m_final;         // per local vertex: star is final
+  std::vector<float2> m_buffer;      // points not triangulated yet
+  float2 m_last;                     // last point added
+  Edge *m_left = nullptr;            // most left hull edge
+  Edge *m_right = nullptr;           // most right hull edge
+  size_t m_strip_size;
+  uint64_t m_num_vertices = 0;
+  uint64_t m_num_edges = 0;
+  size_t m_peak_retained = 0;
+
+  // current block
+  std::vector<StreamEdge> m_block_edges;
+  std::vector<uint64_t> m_block_closed;
+  std::FILE *m_file = nullptr;
+
+  // retire buffers
+  std::vector<Edge *> m_vertex_edge;
+  std::vector<char> m_retired;
+  std::vector<int> m_remap;
+};
+
+/*!
+ * \brief Minimum spanning tree of a streamed triangulation file
+ *
+ * Blocks are read one at a time and MST(A u B) = MST(MST(A) u B) is applied
+ * with the Kruskal engine. The forest is then reduced with closed vertices
+ * (no edge will reach them anymore): the edge of a closed leaf is final, and
+ * of two edges through a closed vertex of degree two, the lighter one is
+ * final while the heavier one is carried by the merged path. Only a forest
+ * about the size of the open vertices stays in memory.
+ */
+class StreamingMst {
+public:
+  /*!
+   * \brief Computes spanning tree of a file written by StreamingDelaunay
+   * \param path input file
+   * \param tree_path output file of tree edges (same format), none if empty
+   * \return min_d, lenght of the longest tree edge
+   * throws std::runtime_error if files cannot be read or written
+   */
+  float computeMinD(const std::string &path, const std::string &tree_path);
+
+  // number of edges of the tree
+  uint64_t numTreeEdges() const { return m_num_tree_edges; }
+
+private:
+  struct ForestEdge {
+    uint64_t u;      // current end points, moved by path contractions
+    uint64_t v;
+    float lenght;
+    uint64_t orig_u; // end points of the triangulation edge
+    uint64_t orig_v;
+  };
+
+  // MST of forest and block edges
+  void mergeBlock(const std::vector<StreamEdge> &block);
+  // writes final forest edges through closed vertices
+  void reduceForest();
+  void emit(const ForestEdge &e);
+
+private:
+  std::vector<ForestEdge> m_forest;
+  std::vector<char> m_dead;
+  std::unordered_map<uint64_t, std::vector<int>> m_closed; // closed -> edges
+  Kruskal m_kruskal;
+  std::vector<WeightedEdge> m_edges;
+  std::vector<ForestEdge> m_candidates;
+  std::unordered_map<uint64_t, int> m_local_id;
+  float m_max_lenght = 0;
+  uint64_t m_num_tree_edges = 0;
+  std::vector<StreamEdge> m_tree_edges; // current output block
+};
@@ -0,0 +1,184 @@
+#include "thread_pool.h"
+
+namespace {
+// pool and index of the worker running on this thread
+struct WorkerId {
+  const ThreadPool *pool;
+  int index;
+};
+thread_local WorkerId t_worker = {nullptr, 0};
+} // namespace
+
+ThreadPool::ThreadPool(int num_threads)
+    : m_num_threads(num_threads < 1 ? 1 : num_threads), m_stop(false),
+      m_num_queued(0) {
+
+  for (int i = 0; i < m_num_threads; i++) {
+    m_workers.emplace_back(new Worker());
+  }
+  // worker 0 is the calling thread
+  for (int i = 1; i < m_num_threads; i++) {
+    m_threads.emplace_back(&ThreadPool::workerLoop, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(m_sleep_mutex);
+    m_stop = true;
+  }
+  m_wake.notify_all();
+  for (auto &t : m_threads) {
+    t.join();
+  }
+}
+
+int ThreadPool::currentWorker() const {
+  return (t_worker.pool == this) ? t_worker.index : 0;
+}
+
+void ThreadPool::push(Task &&task) {
+  Worker &w = *m_workers[currentWorker()];
+  {
+    std::lock_guard<std::mutex> lock(w.mutex);
+    w.tasks.push_back(std::move(task));
+  }
+  m_num_queued++;
+  {
+    // empty critical section: a worker cannot miss the notification between
+    // checking m_num_queued and going to sleep
+    std::lock_guard<std::mutex> lock(m_sleep_mutex);
+  }
+  m_wake.notify_one();
+}
+
+bool ThreadPool::tryRunOne(int self) {
+  Task task;
+  bool found = false;
+
+  // own deque: newest first (depth-first, cache friendly)
+  {
+    Worker &w = *m_workers[self];
+    std::lock_guard<std::mutex> lock(w.mutex);
+    if (!w.tasks.empty()) {
+      task = std::move(w.tasks.back());
+      w.tasks.pop_back();
+      found = true;
+    }
+  }
+
+  // steal oldest task (biggest sub-problem) from others
+  for (int i = 1; !found && i < m_num_threads; i++) {
+    Worker &w = *m_workers[(self + i) % m_num_threads];
+    std::lock_guard<std::mutex> lock(w.mutex);
+    if (!w.tasks.empty()) {
+      task = std::move(w.tasks.front());
+      w.tasks.pop_front();
+      found = true;
+    }
+  }
+
+  if (!found) {
+    return false;
+  }
+  m_num_queued--;
+  task.group->execute(task.fn);
+  return true;
+}
+
+void ThreadPool::workerLoop(int index) {
+  t_worker.pool = this;
+  t_worker.index = index;
+
+  while (true) {
+    if (tryRunOne(index)) {
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(m_sleep_mutex);
+    m_wake.wait(lock, [this] { return m_stop || m_num_queued > 0; });
+    if (m_stop) {
+      return;
+    }
+  }
+}
+
+void ThreadPool::TaskGroup::run(std::function<void()> task) {
+  m_pending++;
+  if (m_pool.m_num_threads == 1) {
+    // nobody to share with
+    execute(task);
+    return;
+  }
+  Task t;
+  t.fn = std::move(task);
+  t.group = this;
+  m_pool.push(std::move(t));
+}
+
+void ThreadPool::TaskGroup::execute(const std::function<void()> &task) {
+  try {
+    task();
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(m_error_mutex);
+    if (!m_error) {
+      m_error = std::current_exception();
+    }
+  }
+  // last: the group may be destroyed as soon as its count drops to 0
+  m_pending--;
+}
+
+void ThreadPool::TaskGroup::join() {
+  const int self = m_pool.currentWorker();
+  while (m_pending > 0) {
+    if (!m_pool.tryRunOne(self)) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+void ThreadPool::TaskGroup::wait() {
+  join();
+  std::exception_ptr error;
+  {
+    std::lock_guard<std::mutex> lock(m_error_mutex);
+    std::swap(error, m_error);
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+void ThreadPool::forRange(ThreadPool *pool, size_t n, size_t grain,
+                          const std::function<void(size_t, size_t)> &body) {
+  if (pool) {
+    pool->parallelFor(0, n, grain, body);
+  } else {
+    body(0, n);
+  }
+}
+
+void ThreadPool::parallelFor(size_t begin, size_t end, size_t grain,
+                             const std::function<void(size_t, size_t)> &body) {
+  if (end <= begin) {
+    return;
+  }
+  if (grain == 0) {
+    grain = 1;
+  }
+  // a few chunks per thread so that stealing can balance the load
+  size_t count = end - begin;
+  size_t num_chunks = static_cast<size_t>(m_num_threads) * 4;
+  size_t chunk = std::max(grain, (count + num_chunks - 1) / num_chunks);
+  if (chunk >= count) {
+    body(begin, end);
+    return;
+  }
+
+  TaskGroup group(*this);
+  for (size_t b = begin; b < end; b += chunk) {
+    size_t e = std::min(end, b + chunk);
+    group.run([&body, b, e] { body(b, e); });
+  }
+  group.wait();
+}
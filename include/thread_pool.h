@@ -0,0 +1,104 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*!
+ * \brief Work-stealing thread pool for fork-join parallelism
+ *
+ * Every worker owns a deque: it pushes and pops its own tasks at the back and
+ * idle workers steal from the front of the others. The thread that drives the
+ * pool (the one calling TaskGroup::wait) is worker 0 and helps executing tasks
+ * while it waits. Only one outside thread should drive a pool at a time.
+ */
+class ThreadPool {
+public:
+  /*!
+   * \brief Creates num_threads-1 threads, calling thread being the last one
+   * \param num_threads total number of threads working, at least 1
+   */
+  explicit ThreadPool(int num_threads);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // number of threads, including calling thread
+  int numThreads() const { return m_num_threads; }
+
+  // index in [0, numThreads) of calling thread (0 if it is not a worker)
+  int currentWorker() const;
+
+  /*!
+   * \brief Set of tasks that can be waited together (fork-join)
+   */
+  class TaskGroup {
+  public:
+    explicit TaskGroup(ThreadPool &pool) : m_pool(pool), m_pending(0) {}
+    // waits too, an exception not rethrown by wait() is dropped
+    ~TaskGroup() { join(); }
+
+    // queues a task on the calling worker's deque
+    void run(std::function<void()> task);
+    // returns once all tasks are done, running pending tasks meanwhile.
+    // Rethrows the first exception thrown by a task of the group.
+    void wait();
+
+  private:
+    friend class ThreadPool;
+    // waits for all tasks without rethrowing
+    void join();
+    // runs a task of the group, keeping its exception, and counts it done
+    void execute(const std::function<void()> &task);
+
+    ThreadPool &m_pool;
+    std::atomic<int> m_pending;
+    std::mutex m_error_mutex;
+    std::exception_ptr m_error; // first exception thrown by a task
+  };
+
+  /*!
+   * \brief Calls body(chunk_begin, chunk_end) over [begin, end) in parallel
+   * \param grain minimum number of elements per chunk
+   */
+  void parallelFor(size_t begin, size_t end, size_t grain,
+                   const std::function<void(size_t, size_t)> &body);
+
+  // body(chunk_begin, chunk_end) over [0, n): parallelFor on pool, or
+  // body(0, n) on the calling thread if pool is null
+  static void forRange(ThreadPool *pool, size_t n, size_t grain,
+                       const std::function<void(size_t, size_t)> &body);
+
+private:
+  struct Task {
+    std::function<void()> fn;
+    TaskGroup *group; // owning it
+  };
+  struct Worker {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void push(Task &&task);
+  // runs one task from own deque or stolen from another one
+  bool tryRunOne(int self);
+  void workerLoop(int index);
+
+private:
+  int m_num_threads;
+  std::vector<std::unique_ptr<Worker>> m_workers; // index 0 = calling thread
+  std::vector<std::thread> m_threads;
+
+  std::atomic<bool> m_stop;
+  std::atomic<int> m_num_queued; // tasks waiting in any deque
+  std::mutex m_sleep_mutex;
+  std::condition_variable m_wake;
+};
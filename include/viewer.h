@@ -1,81 +1,304 @@
 #pragma once
 #include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
 
 #include "delaunay.h"
 
+/*!
+ * \brief SDL2 view of a spanning tree and its vertices
+ *
+ * A result is copied once (setResult) into world space segments, so frames
+ * never chase edge pointers. Each frame maps them to the window, drops the
+ * edges out of it (culling) and the ones shorter than a pixel (their end
+ * points are drawn anyway), drops vertices on a pixel already drawn, and
+ * submits all that is left in a single SDL_RenderGeometry call.
+ *
+ * Frames are drawn in an off-screen target texture, then copied to the
+ * window. A headless viewer has no window (no display needed): it renders
+ * with the software renderer and frames are only saved with savePng.
+ */
 class Viewer {
 public:
-  Viewer(int WindowWidth, int WindowHeigh) {
+  Viewer(int WindowWidth, int WindowHeigh, bool headless = false);
+  ~Viewer();
+
+  // copies edges end points and vertices, fits the view on vertices
+  void setResult(const std::vector<Edge *> &vector_e,
+                 const std::vector<float2> &vertex);
+  // same from world space segments (2 end points per edge), taken by swap:
+  // the buffers of the previous result are handed back
+  void swapResult(std::vector<float2> &segments,
+                  std::vector<float2> &vertices);
+  // draws the result with the current view, shows it in the window
+  void render();
+
+  void show(const std::vector<Edge *> &vector_e,
+            const std::vector<float2> &vertex) {
+    setResult(vector_e, vertex);
+    render();
+  }
+
+  // zooms by factor, window point (x, y) staying in place
+  void zoom(float factor, int x, int y);
+  // fits the view on all vertices
+  void resetView();
+
+  /*!
+   * \brief Saves last rendered frame
+   * \return false on failure, SDL_GetError() telling why
+   */
+  bool savePng(const char *path);
+
+  // primitives submitted by last render, after culling and level of detail
+  size_t numDrawnEdges() const { return m_drawn_edges; }
+  size_t numDrawnVertices() const { return m_drawn_vertices; }
+
+private:
+  // screen position of a world point
+  SDL_FPoint toScreen(const float2 &p) const {
+    return SDL_FPoint{p.x * m_scale + m_offset.x, p.y * m_scale + m_offset.y};
+  }
+  // bounds of the result, then view fitted on them
+  void fitResult();
+  // adds a quad of 4 vertices (2 triangles) to the frame geometry
+  void addQuad(const SDL_FPoint (&corners)[4], const SDL_Color &color);
+  // fills the frame geometry from the result and the view
+  void buildFrame();
 
-    // Init
+private:
+  SDL_Window *window = nullptr; // null when headless
+  SDL_Renderer *renderer = nullptr;
+  SDL_Surface *m_surface = nullptr; // pixels of the headless renderer
+  SDL_Texture *m_target = nullptr;  // frame, drawn off-screen
+  int m_width;
+  int m_height;
+
+  // result, world space
+  std::vector<float2> m_segments; // 2 end points per edge
+  std::vector<float2> m_vertices;
+  float2 m_min;
+  float2 m_max;
+
+  // view: screen = world * m_scale + m_offset
+  float m_scale = 1;
+  float2 m_offset;
+
+  // frame, reused
+  std::vector<SDL_Vertex> m_geometry;
+  std::vector<int> m_indices;
+  std::vector<uint8_t> m_covered; // per pixel, a vertex was drawn on it
+  size_t m_drawn_edges = 0;
+  size_t m_drawn_vertices = 0;
+};
+
+namespace viewer {
+const SDL_Color kBackground = {242, 242, 242, 255};
+const SDL_Color kEdgeColor = {255, 0, 0, 255};
+const SDL_Color kVertexColor = {0, 0x70, 0, 255};
+const float kEdgeHalfWidth = 1.0f;  // pixels
+const float kVertexHalfSize = 1.5f; // pixels
+const float kFitMargin = 8.0f;      // pixels around vertices when fitted
+const Uint32 kFormat = SDL_PIXELFORMAT_ARGB8888;
+} // namespace viewer
+
+inline Viewer::Viewer(int WindowWidth, int WindowHeigh, bool headless)
+    : m_width(WindowWidth), m_height(WindowHeigh) {
+
+  // Init
+  if (headless) {
+    SDL_Init(0);
+    m_surface = SDL_CreateRGBSurfaceWithFormat(0, WindowWidth, WindowHeigh,
+                                               32, viewer::kFormat);
+    renderer = SDL_CreateSoftwareRenderer(m_surface);
+  } else {
     SDL_Init(SDL_INIT_VIDEO);
     window =
         SDL_CreateWindow("SDL2 line drawing", SDL_WINDOWPOS_UNDEFINED,
                          SDL_WINDOWPOS_UNDEFINED, WindowWidth, WindowHeigh, 0);
+    renderer = SDL_CreateRenderer(window, -1,
+                                  SDL_RENDERER_ACCELERATED |
+                                      SDL_RENDERER_TARGETTEXTURE);
+  }
+  m_target = SDL_CreateTexture(renderer, viewer::kFormat,
+                               SDL_TEXTUREACCESS_TARGET, WindowWidth,
+                               WindowHeigh);
+  IMG_Init(IMG_INIT_PNG);
+}
 
-    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
-  };
-
-  ~Viewer() {
-    SDL_DestroyRenderer(renderer);
+inline Viewer::~Viewer() {
+  IMG_Quit();
+  SDL_DestroyTexture(m_target);
+  SDL_DestroyRenderer(renderer);
+  if (m_surface) {
+    SDL_FreeSurface(m_surface);
+  }
+  if (window) {
     SDL_DestroyWindow(window);
-    SDL_Quit();
   }
+  SDL_Quit();
+}
 
-  void show(const std::vector<Edge *> &vector_e,
-            const std::vector<float2> &vertex) {
-    clear();
-    drawAll(vector_e, 255, 0, 0);
-    drawVertex(vertex, 0, 0x70, 0, 3);
-    render();
+inline void Viewer::setResult(const std::vector<Edge *> &vector_e,
+                              const std::vector<float2> &vertex) {
+  m_segments.clear();
+  m_segments.reserve(2 * vector_e.size());
+  for (Edge *e : vector_e) {
+    m_segments.push_back(vertex[e->Org()]);
+    m_segments.push_back(vertex[e->Dest()]);
   }
+  m_vertices.assign(vertex.begin(), vertex.end());
+  fitResult();
+}
 
-private:
-  void render() { SDL_RenderPresent(renderer); }
-  void clear() {
-    SDL_SetRenderDrawColor(renderer, 242, 242, 242, 255);
-    SDL_RenderClear(renderer);
-  }
+inline void Viewer::swapResult(std::vector<float2> &segments,
+                               std::vector<float2> &vertices) {
+  m_segments.swap(segments);
+  m_vertices.swap(vertices);
+  fitResult();
+}
 
-  void drawEdge(const Edge &, int, int, int);
-  void drawAll(const std::vector<Edge *> &vector_e, int, int, int);
-  void drawVertex(const std::vector<float2> &, int, int, int, int);
+inline void Viewer::fitResult() {
+  m_min = m_max = m_vertices.empty() ? float2() : m_vertices.front();
+  for (const float2 &v : m_vertices) {
+    m_min.x = std::min(m_min.x, v.x);
+    m_min.y = std::min(m_min.y, v.y);
+    m_max.x = std::max(m_max.x, v.x);
+    m_max.y = std::max(m_max.y, v.y);
+  }
+  resetView();
+}
 
-private:
-  SDL_Window *window;
-  SDL_Renderer *renderer;
-};
+inline void Viewer::resetView() {
+  const float width = m_width - 2 * viewer::kFitMargin;
+  const float height = m_height - 2 * viewer::kFitMargin;
+  const float extent_x = m_max.x - m_min.x;
+  const float extent_y = m_max.y - m_min.y;
+  m_scale = 1;
+  if (extent_x > 0 || extent_y > 0) {
+    // a zero extent (collinear vertices) does not constrain the scale
+    const float inf = std::numeric_limits<float>::infinity();
+    m_scale = std::min(extent_x > 0 ? width / extent_x : inf,
+                       extent_y > 0 ? height / extent_y : inf);
+  }
+  // centers vertices
+  m_offset.x = 0.5f * (m_width - (m_min.x + m_max.x) * m_scale);
+  m_offset.y = 0.5f * (m_height - (m_min.y + m_max.y) * m_scale);
+}
 
-void Viewer::drawEdge(const Edge &e, int r, int g, int b) {
-  SDL_RenderSetScale(renderer, 2, 2);
-  SDL_SetRenderDrawColor(renderer, r, g, b, 255);
+inline void Viewer::zoom(float factor, int x, int y) {
+  m_offset.x = x - (x - m_offset.x) * factor;
+  m_offset.y = y - (y - m_offset.y) * factor;
+  m_scale *= factor;
+}
 
-  auto &origin = e.Org2d();
-  auto &dest = e.Dest2d();
-  SDL_RenderDrawLine(renderer, origin.x / 2, origin.y / 2, dest.x / 2,
-                     dest.y / 2);
-  SDL_RenderSetScale(renderer, 1, 1);
+inline void Viewer::addQuad(const SDL_FPoint (&corners)[4],
+                            const SDL_Color &color) {
+  const int first = static_cast<int>(m_geometry.size());
+  for (const SDL_FPoint &corner : corners) {
+    m_geometry.push_back(SDL_Vertex{corner, color, SDL_FPoint{0, 0}});
+  }
+  const int quad[6] = {0, 1, 2, 2, 1, 3};
+  for (int i : quad) {
+    m_indices.push_back(first + i);
+  }
 }
 
-void Viewer::drawAll(const std::vector<Edge *> &vector_e, int r, int g, int b) {
+inline void Viewer::buildFrame() {
+  m_geometry.clear();
+  m_indices.clear();
+  m_drawn_edges = 0;
+  m_drawn_vertices = 0;
+  const float w = static_cast<float>(m_width);
+  const float h = static_cast<float>(m_height);
+
+  // edges: culled when both ends are on the same outer side of the window
+  // (lines widened by their width), skipped below a pixel
+  const float pad = viewer::kEdgeHalfWidth;
+  for (size_t i = 0; i < m_segments.size(); i += 2) {
+    const SDL_FPoint a = toScreen(m_segments[i]);
+    const SDL_FPoint b = toScreen(m_segments[i + 1]);
+    if ((a.x < -pad && b.x < -pad) || (a.x > w + pad && b.x > w + pad) ||
+        (a.y < -pad && b.y < -pad) || (a.y > h + pad && b.y > h + pad)) {
+      continue;
+    }
+    const float dx = b.x - a.x;
+    const float dy = b.y - a.y;
+    const float lenght_squared = dx * dx + dy * dy;
+    if (lenght_squared < 1.0f) {
+      continue;
+    }
+    // half width along the normal of the edge
+    const float k = viewer::kEdgeHalfWidth / std::sqrt(lenght_squared);
+    const float nx = -dy * k;
+    const float ny = dx * k;
+    const SDL_FPoint corners[4] = {{a.x + nx, a.y + ny},
+                                   {a.x - nx, a.y - ny},
+                                   {b.x + nx, b.y + ny},
+                                   {b.x - nx, b.y - ny}};
+    addQuad(corners, viewer::kEdgeColor);
+    m_drawn_edges++;
+  }
 
-  int i = 0;
-  for (auto e : vector_e) {
-    // std::cout << "i:" << i << std::endl;
-    i++;
-    // std::cout << e->Qedge()->lenght_sqrt << std::endl;
-    drawEdge(*e, r, g, b);
+  // vertices on top, at most one per pixel
+  m_covered.assign(static_cast<size_t>(m_width) * m_height, 0);
+  const float s = viewer::kVertexHalfSize;
+  for (const float2 &v : m_vertices) {
+    const SDL_FPoint p = toScreen(v);
+    if (p.x < 0 || p.y < 0 || p.x >= w || p.y >= h) {
+      continue;
+    }
+    uint8_t &covered = m_covered[static_cast<size_t>(p.y) * m_width +
+                                 static_cast<size_t>(p.x)];
+    if (covered) {
+      continue;
+    }
+    covered = 1;
+    const SDL_FPoint corners[4] = {{p.x - s, p.y - s},
+                                   {p.x + s, p.y - s},
+                                   {p.x - s, p.y + s},
+                                   {p.x + s, p.y + s}};
+    addQuad(corners, viewer::kVertexColor);
+    m_drawn_vertices++;
   }
 }
 
-void Viewer::drawVertex(const std::vector<float2> &vertex, int r, int g, int b,
-                        int scale) {
+inline void Viewer::render() {
+  buildFrame();
+
+  SDL_SetRenderTarget(renderer, m_target);
+  const SDL_Color &bg = viewer::kBackground;
+  SDL_SetRenderDrawColor(renderer, bg.r, bg.g, bg.b, bg.a);
+  SDL_RenderClear(renderer);
+  if (!m_indices.empty()) {
+    SDL_RenderGeometry(renderer, nullptr, m_geometry.data(),
+                       static_cast<int>(m_geometry.size()), m_indices.data(),
+                       static_cast<int>(m_indices.size()));
+  }
+  SDL_SetRenderTarget(renderer, nullptr);
+
+  if (window) {
+    SDL_RenderCopy(renderer, m_target, nullptr, nullptr);
+    SDL_RenderPresent(renderer);
+  }
+}
 
-  SDL_RenderSetScale(renderer, scale, scale);
-  SDL_SetRenderDrawColor(renderer, r, g, b, 255);
-  for (auto v : vertex) {
-    SDL_RenderDrawPoint(renderer, v.x / scale, v.y / scale);
+inline bool Viewer::savePng(const char *path) {
+  SDL_Surface *frame = SDL_CreateRGBSurfaceWithFormat(0, m_width, m_height,
+                                                      32, viewer::kFormat);
+  if (!frame) {
+    return false;
   }
-  SDL_RenderSetScale(renderer, 1, 1);
-  return;
+  SDL_SetRenderTarget(renderer, m_target);
+  bool saved = SDL_RenderReadPixels(renderer, nullptr, viewer::kFormat,
+                                    frame->pixels, frame->pitch) == 0 &&
+               IMG_SavePNG(frame, path) == 0;
+  SDL_SetRenderTarget(renderer, nullptr);
+  SDL_FreeSurface(frame);
+  return saved;
 }
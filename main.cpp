@@ -1,11 +1,18 @@
 
 #include <chrono>
+#include <condition_variable>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <random>
+#include <string>
 #include <thread>
 #include <vector>
 
 #include "include/delaunay.h"
+#include "include/loader.h"
+#include "include/pipeline.h"
 #include "include/viewer.h"
 
 // 1130932488
@@ -15,6 +22,15 @@ namespace ch = std::chrono;
 
 #define WINDOW_WIDTH 10
 #define WINDOW_HEIGHT 10
+// pixels of the view, points are fitted in it
+#define VIEW_WIDTH 1000
+#define VIEW_HEIGHT 1000
+// drift mode: largest move of a star per frame
+#define DRIFT_STEP 0.002f
+// pipelined mode: frames in flight (one per stage, one waiting for render)
+#define PIPELINE_FRAMES 4
+// pipelined mode: longest wait for an event before looking for a result
+#define EVENT_WAIT_MS 5
 
 const float WIDTH_OFFSET = 0 / 2;
 const float HEIGHT_OFFSET = 0 / 2;
@@ -22,10 +38,9 @@ const float HEIGHT_OFFSET = 0 / 2;
 // const float HEIGHT_OFFSET = WINDOW_HEIGHT / 2;
 
 const int NUMBER_STARS = 50000;
-std::vector<float2> const generateRandomPoints(size_t num_points,
-                                               float radius_x, float radius_y,
-                                               float2 offset) {
-  std::vector<float2> points;
+void generateRandomPoints(size_t num_points, float radius_x, float radius_y,
+                          float2 offset, std::vector<float2> &points) {
+  points.clear();
   points.reserve(num_points);
 
   std::random_device rd;
@@ -44,78 +59,440 @@ std::vector<float2> const generateRandomPoints(size_t num_points,
     float2 const pos((dis_x(gen)) + offset.x, (dis_y(gen)) + offset.y);
     points.emplace_back(pos);
   }
+}
+
+// state changed by events, shared by both frame loops
+struct Controls {
+  bool quit = false;
+  bool update = true; // new stars (and spanning tree) wanted
+  bool draw = true;
+  bool drift = false; // stars move a little every frame (kinetic updates)
+  MstBackend mst_backend = MstBackend::Kruskal;
+};
+
+void handleEvent(const SDL_Event &event, Viewer &viewer, Controls &controls) {
+  switch (event.type) {
+    // shutdown window key
+  case SDL_QUIT:
+    controls.quit = true;
+    break;
 
-  return points;
+  // a key pressed down
+  case SDL_KEYDOWN:
+    switch (event.key.keysym.sym) {
+    case SDLK_ESCAPE:
+      controls.quit = true;
+      break;
+    case SDLK_SPACE:
+      controls.update = true;
+      break;
+    case SDLK_RETURN:
+      controls.draw = !controls.draw;
+      break;
+    case SDLK_k:
+      controls.drift = !controls.drift;
+      break;
+    case SDLK_r:
+      viewer.resetView();
+      viewer.render();
+      break;
+    case SDLK_b:
+      controls.mst_backend = (controls.mst_backend == MstBackend::Kruskal)
+                                 ? MstBackend::Boruvka
+                                 : MstBackend::Kruskal;
+      controls.update = true;
+      break;
+    }
+    break;
+
+  // wheel zooms around the mouse
+  case SDL_MOUSEWHEEL: {
+    int x, y;
+    SDL_GetMouseState(&x, &y);
+    viewer.zoom(event.wheel.y > 0 ? 1.25f : 0.8f, x, y);
+    viewer.render();
+    break;
+  }
+  }
 }
 
-int main() {
+/*************** Pipelined mode ***************/
+// A frame goes through 3 stages, each on its own thread: generate (stars),
+// triangulate, spanning tree. Frames are recycled: a stage waits for the
+// next one when the following stage is busy (bounded queues), so the rate
+// is the one of the slowest stage. Spanning trees are published as the
+// latest result, which the event thread renders when it gets to it.
 
-  // Viewer
-  Viewer viewer(WINDOW_WIDTH, WINDOW_HEIGHT);
+struct Frame {
+  uint64_t generation = 0; // star set, drift frames keep it
+  bool drift = false;      // stars of the set moved since last frame
+  MstBackend mst_backend = MstBackend::Kruskal;
+  std::vector<float2> points; // stars, input of the triangulation
+  // kept with the frame: drift moves the vertices of its triangulation
+  DivideConquer dc;
+  uint64_t dc_generation = 0; // star set triangulated by dc, 0: none
+  std::vector<int> drift_ids;     // vertices of dc
+  std::vector<int> drift_inputs;  // one star of each of them
+  std::vector<float2> drift_positions;
+  bool repaired = false; // drift repaired by flips, not recomputed
+  std::vector<Edge *> solution;
+  float min_d = 0;
+  // render ready, world space
+  std::vector<float2> segments; // 2 end points per tree edge
+  std::vector<float2> vertices;
+  // ms spent by each stage
+  double generate_time = 0;
+  double delaunay_time = 0;
+  double mst_time = 0;
+};
+typedef std::unique_ptr<Frame> FramePtr;
 
-  /*************** Rendering cycle ***************/
+// requests of the event thread to the generate stage
+struct Requests {
+  std::mutex mutex;
+  std::condition_variable changed;
+  uint64_t generation = 0; // bumped for new stars
+  bool drift = false;
+  MstBackend mst_backend = MstBackend::Kruskal;
   bool quit = false;
-  bool update = true;
-  bool draw = true;
-  while (!quit) {
+};
 
-    // get events
+inline double msSince(ch::steady_clock::time_point t) {
+  return ch::duration<double, std::milli>(NOW() - t).count();
+}
+
+// file_points: stars of the file, null for random stars
+void generateStage(Requests &requests, const PointSpan *file_points,
+                   BoundedQueue<FramePtr> &free_frames,
+                   BoundedQueue<FramePtr> &to_triangulate) {
+  uint64_t generated = 0; // generation of stars
+  std::vector<float2> stars;
+  std::mt19937 drift_gen(42);
+  std::uniform_real_distribution<float> drift_step(-DRIFT_STEP, DRIFT_STEP);
+  while (true) {
+    // new stars, or moved ones
+    uint64_t generation;
+    bool drift;
+    MstBackend mst_backend;
+    {
+      std::unique_lock<std::mutex> lock(requests.mutex);
+      requests.changed.wait(lock, [&] {
+        return requests.quit || requests.generation != generated ||
+               requests.drift;
+      });
+      if (requests.quit) {
+        return;
+      }
+      generation = requests.generation;
+      drift = requests.drift && generation == generated;
+      mst_backend = requests.mst_backend;
+    }
+    FramePtr frame;
+    if (!free_frames.pop(frame)) {
+      return;
+    }
+    auto t = NOW();
+    if (!drift) {
+      if (file_points) {
+        stars.assign(file_points->data,
+                     file_points->data + file_points->size);
+      } else {
+        generateRandomPoints(NUMBER_STARS, WINDOW_WIDTH / 2,
+                             WINDOW_HEIGHT / 2,
+                             float2(WIDTH_OFFSET, HEIGHT_OFFSET), stars);
+      }
+      generated = generation;
+    } else {
+      for (float2 &star : stars) {
+        star = float2(star.x + drift_step(drift_gen),
+                      star.y + drift_step(drift_gen));
+      }
+    }
+    frame->generation = generation;
+    frame->drift = drift;
+    frame->mst_backend = mst_backend;
+    frame->points.assign(stars.begin(), stars.end());
+    frame->generate_time = msSince(t);
+    if (!to_triangulate.push(frame)) {
+      return;
+    }
+  }
+}
+
+void triangulateStage(BoundedQueue<FramePtr> &to_triangulate,
+                      BoundedQueue<FramePtr> &to_mst) {
+  FramePtr frame;
+  while (to_triangulate.pop(frame)) {
+    auto t = NOW();
+    DivideConquer &dc = frame->dc;
+    if (frame->drift && frame->dc_generation == frame->generation) {
+      // dc holds the same stars, some frames ago: moves its vertices
+      const size_t num_moved = frame->drift_ids.size();
+      frame->drift_positions.resize(num_moved);
+      for (size_t i = 0; i < num_moved; i++) {
+        frame->drift_positions[i] = frame->points[frame->drift_inputs[i]];
+      }
+      frame->repaired = dc.moveVertices(frame->drift_ids.data(),
+                                        frame->drift_positions.data(),
+                                        num_moved);
+    } else {
+      dc.computeTriangulation(frame->points.data(), frame->points.size());
+      frame->dc_generation = frame->generation;
+      frame->repaired = false;
+      // duplicated stars share their vertex: the first one moves it
+      const std::vector<int> &input_to_vertex = dc.inputToVertex();
+      std::vector<char> seen(dc.orderedPoints().size(), 0);
+      frame->drift_ids.clear();
+      frame->drift_inputs.clear();
+      for (size_t i = 0; i < input_to_vertex.size(); i++) {
+        const int v = input_to_vertex[i];
+        if (!seen[v]) {
+          seen[v] = 1;
+          frame->drift_ids.push_back(v);
+          frame->drift_inputs.push_back(static_cast<int>(i));
+        }
+      }
+    }
+    frame->delaunay_time = msSince(t);
+    if (!to_mst.push(frame)) {
+      return;
+    }
+  }
+}
+
+void mstStage(BoundedQueue<FramePtr> &to_mst,
+              BoundedQueue<FramePtr> &free_frames,
+              LatestValue<FramePtr> &latest) {
+  FramePtr frame;
+  while (to_mst.pop(frame)) {
+    auto t = NOW();
+    DivideConquer &dc = frame->dc;
+    frame->solution.clear();
+    dc.setMstBackend(frame->mst_backend);
+    frame->min_d = dc.computeMinD(frame->solution);
+    // copied out: the event thread never reads dc
+    const std::vector<float2> &vertices = dc.orderedPoints();
+    frame->segments.clear();
+    for (Edge *e : frame->solution) {
+      frame->segments.push_back(vertices[e->Org()]);
+      frame->segments.push_back(vertices[e->Dest()]);
+    }
+    frame->vertices.assign(vertices.begin(), vertices.end());
+    frame->mst_time = msSince(t);
+
+    // a result not rendered yet is replaced, and recycled
+    latest.publish(frame);
+    if (frame && !free_frames.push(frame)) {
+      return;
+    }
+  }
+}
+
+// frame loop of the pipelined mode, returns the exit code
+int runPipelined(Viewer &viewer, const PointSpan *file_points,
+                 const char *png_path) {
+  BoundedQueue<FramePtr> free_frames(PIPELINE_FRAMES);
+  BoundedQueue<FramePtr> to_triangulate(1);
+  BoundedQueue<FramePtr> to_mst(1);
+  LatestValue<FramePtr> latest;
+  for (int i = 0; i < PIPELINE_FRAMES; i++) {
+    FramePtr frame(new Frame());
+    free_frames.push(frame);
+  }
+
+  Controls controls;
+  Requests requests;
+  std::thread generate(generateStage, std::ref(requests), file_points,
+                       std::ref(free_frames), std::ref(to_triangulate));
+  std::thread triangulate(triangulateStage, std::ref(to_triangulate),
+                          std::ref(to_mst));
+  std::thread mst(mstStage, std::ref(to_mst), std::ref(free_frames),
+                  std::ref(latest));
+
+  int status = 0;
+  size_t num_rendered = 0; // since last report
+  auto report = NOW();
+  while (!controls.quit) {
+    // waits a little for events: idle without spinning, results still
+    // rendered as they come
     SDL_Event event;
-    while (SDL_PollEvent(&event)) {
+    if (SDL_WaitEventTimeout(&event, EVENT_WAIT_MS)) {
+      do {
+        handleEvent(event, viewer, controls);
+      } while (SDL_PollEvent(&event));
+    }
+    {
+      std::lock_guard<std::mutex> lock(requests.mutex);
+      if (controls.update) {
+        controls.update = false;
+        requests.generation++;
+      }
+      requests.drift = controls.drift;
+      requests.mst_backend = controls.mst_backend;
+    }
+    requests.changed.notify_one();
 
-      switch (event.type) {
-        // shutdown window key
-      case SDL_QUIT:
-        quit = true;
-        break;
-
-      // a key pressed down
-      case SDL_KEYDOWN:
-        switch (event.key.keysym.sym) {
-        case SDLK_ESCAPE:
-          quit = true;
-          break;
-        case SDLK_SPACE:
-          update = true;
-          break;
-        case SDLK_RETURN:
-          draw = !draw;
-          break;
+    FramePtr frame;
+    if (latest.take(frame)) {
+      auto rt = NOW();
+      viewer.swapResult(frame->segments, frame->vertices);
+      if (controls.draw || png_path) {
+        viewer.render();
+      }
+      num_rendered++;
+      const double render_time = msSince(rt);
+      const double seconds = msSince(report) / 1000;
+      if (seconds >= 1.0 || png_path) {
+        std::cout << "fps: " << num_rendered / seconds
+                  << ", last frame: generate " << frame->generate_time
+                  << "ms, "
+                  << (frame->drift ? (frame->repaired ? "kinetic "
+                                                      : "kinetic recomputed ")
+                                   : "delaunay ")
+                  << frame->delaunay_time << "ms, "
+                  << (frame->mst_backend == MstBackend::Kruskal ? "kruskal "
+                                                                : "boruvka ")
+                  << frame->mst_time << "ms, render " << render_time
+                  << "ms, min_d: " << frame->min_d << std::endl;
+        num_rendered = 0;
+        report = NOW();
+      }
+      free_frames.push(frame);
+
+      if (png_path) {
+        if (!viewer.savePng(png_path)) {
+          std::cerr << "cannot save " << png_path << ": " << SDL_GetError()
+                    << std::endl;
+          status = 1;
+        } else {
+          std::cout << "Saved " << png_path << std::endl;
         }
-        break;
+        controls.quit = true;
       }
-    } // end of pull event while
+    }
+  }
+
+  // stages leave their loop, blocked or not
+  {
+    std::lock_guard<std::mutex> lock(requests.mutex);
+    requests.quit = true;
+  }
+  requests.changed.notify_one();
+  free_frames.close();
+  to_triangulate.close();
+  to_mst.close();
+  generate.join();
+  triangulate.join();
+  mst.join();
+  return status;
+}
+
+int main(int argc, char *argv[]) {
+
+  // Usage: Stars [point file] [--headless image.png] [--pipelined]
+  const char *points_path = nullptr;
+  const char *png_path = nullptr; // headless: renders once, saves, quits
+  bool pipelined = false; // stages on their own threads
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--headless") == 0 && i + 1 < argc) {
+      png_path = argv[++i];
+    } else if (std::strcmp(argv[i], "--pipelined") == 0) {
+      pipelined = true;
+    } else {
+      points_path = argv[i];
+    }
+  }
 
-    if (update) {
+  // Input: a point file (see PointLoader::load) or random points
+  PointLoader loader;
+  PointSpan file_points;
+  if (points_path) {
+    file_points = loader.load(points_path);
+    std::cout << "Loaded " << file_points.size << " points in "
+              << loader.stats().seconds * 1000 << "ms ("
+              << loader.stats().megabytesPerSecond() << " MB/s)" << std::endl;
+  }
 
-      // Input
+  // Viewer
+  Viewer viewer(VIEW_WIDTH, VIEW_HEIGHT, png_path != nullptr);
+  if (pipelined) {
+    return runPipelined(viewer, points_path ? &file_points : nullptr,
+                        png_path);
+  }
 
-      // Output
-      std::vector<Edge *> solution;
+  /*************** Rendering cycle ***************/
+  Controls controls;
 
-      update = false;
+  // kept from frame to frame: buffers keep their capacity
+  DivideConquer DC;
+  std::vector<float2> rng;
+  // drift: moved vertices and their new positions
+  std::vector<int> drift_ids;
+  std::vector<float2> drift_positions;
+  std::mt19937 drift_gen(42);
+  std::uniform_real_distribution<float> drift_step(-DRIFT_STEP, DRIFT_STEP);
+  // Output
+  std::vector<Edge *> solution;
+  while (!controls.quit) {
 
-      // Delaunay
-      DivideConquer DC;
+    // get events
+    SDL_Event event;
+    while (SDL_PollEvent(&event)) {
+      handleEvent(event, viewer, controls);
+    } // end of pull event while
+
+    bool changed = controls.update || controls.drift;
+    auto t = NOW();
+    if (controls.update) {
+      controls.update = false;
 
       /********************* Generate Input ********************/
-      std::vector<float2> const rng = generateRandomPoints(
-          NUMBER_STARS, WINDOW_WIDTH / 2, WINDOW_HEIGHT / 2,
-          float2(WIDTH_OFFSET, HEIGHT_OFFSET));
+      PointSpan input = file_points;
+      if (!points_path) {
+        generateRandomPoints(NUMBER_STARS, WINDOW_WIDTH / 2, WINDOW_HEIGHT / 2,
+                             float2(WIDTH_OFFSET, HEIGHT_OFFSET), rng);
+        input.data = rng.data();
+        input.size = rng.size();
+      }
 
       /******************  Delaunay   *************/
       // Compute Divide&Conquer and compute triangulation
-      auto t = NOW();
-      DC.computeTriangulation(rng);
+      DC.computeTriangulation(input.data, input.size);
       std::cout << "Time Delaunay: "
                 << ch::duration_cast<ch::milliseconds>(NOW() - t).count()
                 << "ms" << std::endl;
+    } else if (controls.drift) {
+      /******************  Kinetic   **************/
+      // Move every star a little, repair the triangulation
+      const std::vector<float2> &stars = DC.orderedPoints();
+      drift_ids.resize(stars.size());
+      drift_positions.resize(stars.size());
+      for (size_t v = 0; v < stars.size(); v++) {
+        drift_ids[v] = static_cast<int>(v);
+        drift_positions[v] = float2(stars[v].x + drift_step(drift_gen),
+                                    stars[v].y + drift_step(drift_gen));
+      }
+      bool repaired = DC.moveVertices(drift_ids.data(), drift_positions.data(),
+                                      drift_positions.size());
+      std::cout << "Time kinetic: "
+                << ch::duration_cast<ch::milliseconds>(NOW() - t).count()
+                << "ms ("
+                << (repaired ? std::to_string(DC.numFlips()) + " flips"
+                             : std::string("recomputed"))
+                << ")" << std::endl;
+    }
 
-      /******************  Kruskal   **************/
-      // Compute Kruskal
+    if (changed) {
+      solution.clear();
+
+      /******************  MST   ******************/
+      // Compute Kruskal or Boruvka
       auto kt = ch::steady_clock::now();
-      float min_d = DC.computeKruskalMinD(solution);
-      std::cout << "Time Kruskal: "
+      DC.setMstBackend(controls.mst_backend);
+      float min_d = DC.computeMinD(solution);
+      std::cout << ((controls.mst_backend == MstBackend::Kruskal)
+                        ? "Time Kruskal: "
+                        : "Time Boruvka: ")
                 << ch::duration_cast<ch::milliseconds>(NOW() - kt).count()
                 << "ms" << std::endl;
 
@@ -126,9 +503,25 @@ int main() {
       std::cout << "min_d: " << min_d << std::endl;
 
       // show
-      if (draw) {
-        viewer.show(solution, rng);
+      if (controls.draw || png_path) {
+        auto rt = NOW();
+        viewer.show(solution, DC.orderedPoints());
+        std::cout << "Time render: "
+                  << ch::duration_cast<ch::milliseconds>(NOW() - rt).count()
+                  << "ms (" << viewer.numDrawnEdges() << " edges, "
+                  << viewer.numDrawnVertices() << " vertices drawn)"
+                  << std::endl;
+      }
+    }
+
+    if (png_path) {
+      if (!viewer.savePng(png_path)) {
+        std::cerr << "cannot save " << png_path << ": " << SDL_GetError()
+                  << std::endl;
+        return 1;
       }
+      std::cout << "Saved " << png_path << std::endl;
+      controls.quit = true;
     }
   }
 